@@ -2,6 +2,8 @@
 // Created by saleh on 11/30/24.
 //
 
+#include <optional>
+
 #include "bench01.h"
 #include "symengine/symbol.h"
 #include "symengine/constants.h"
@@ -9,7 +11,40 @@
 #include "symengine/mul.h"
 #include "symengine/pow.h"
 #include "utils/visitor_sym.h"
+#include "utils/expr_builder.h"
+#include "utils/expr_image.h"
+#include "utils/mmap_streambuf.h"
+#include "utils/vec_serialization.h"
 
+namespace {
+    /**
+     * The query that stands for the first use of an expr: the sum of the exponents of its terms.
+     */
+    long sum_of_exponents(const SymEngine::Basic &expr) {
+        long sum = 0;
+        for (const auto &[term, coef] : SymEngine::down_cast<const SymEngine::Add &>(expr).get_dict()) {
+            if (SymEngine::is_a<SymEngine::Pow>(*term)) {
+                const auto &exp = *SymEngine::down_cast<const SymEngine::Pow &>(*term).get_exp();
+                sum += SymEngine::down_cast<const SymEngine::Integer &>(exp).as_int();
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * The same query, on the image of the expr.
+     */
+    long sum_of_exponents(const expr_image::node &expr) {
+        long sum = 0;
+        for (size_t k = 0; k < expr.count(); k++) {
+            const auto term = expr.key(k);
+            if (term.type() == expr_image::POW) {
+                sum += term.child(1).value();
+            }
+        }
+        return sum;
+    }
+}
 
 void bench01::Preparation() {
     for (size_t flat = 0; flat < cfg_L; flat++) {
@@ -32,9 +67,10 @@ void bench01::Preparation() {
 void bench01::Workload() {
     std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
     {
-        mem_usage_tracker mem_expr_gen(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".expr_gen.txt", true);
+        auto phase = Phase("expr_gen");
+        phase.SetUnits(cfg_N * cfg_L, "term");
+        add_builder builder(cfg_L);
         for (size_t i = 0; i < cfg_N; i++) {
-            SymEngine::RCP<const SymEngine::Basic> expr = SymEngine::zero;
             for (size_t j = 0; j < cfg_L; j++) {
                 auto base = SymEngine::add(
                     SymEngine::add(
@@ -43,30 +79,58 @@ void bench01::Workload() {
                     ),
                     id_to_sym[get_symbol_id(2, j)]
                 );
-                expr = SymEngine::add(expr, SymEngine::pow(base, SymEngine::integer(get_random_integer(1, cfg_P))));
+                builder.add_term(SymEngine::pow(base, SymEngine::integer(get_random_integer(1, cfg_P))));
             }
+            auto expr = builder.build();
             //exprs.push_back(SymEngine::expand(expr));
             exprs.push_back(expr);
         }
     }
 
+    // Outside of any phase, so it does not pollute the counters of the phases.
+    const size_t node_count = count_unique_nodes(exprs);
+    std::cout << "Number of unique nodes in the exprs: " << node_count << std::endl;
+
     std::cout << "Saving the exprs onto the disk." << std::endl;
     {
-        mem_usage_tracker mem_expr_save(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".expr_save.txt", true);
+        auto phase = Phase("expr_save");
+        phase.SetUnits(node_count);
 
+        // The exprs are serialized straight into a mapped file, without a std::string holding the whole blob. The
+        // exprs have the same shape, so each file is pre-sized to the size of the previous one.
+        size_t size_hint = 64 << 20;
         for (size_t i = 0; i < cfg_N; i++) {
-            // create a binary file and save the data as binary
-            auto file = std::ofstream("expr_" + std::to_string(i) + ".bin", std::ios::binary);
-            auto data = exprs[i]->dumps();
-            file.write(data.c_str(), data.size());
-            file.close();
-            std::cout << "expr_" << i << " size: " << data.size() << " has been saved" << std::endl;
+            mmap_streambuf buf("expr_" + std::to_string(i) + ".bin", size_hint);
+            std::ostream os(&buf);
+            dump_to(os, exprs[i]);
+            if (!os) {throw std::runtime_error("Cannot save expr_" + std::to_string(i));}
+            const size_t size = buf.size();
+            buf.close();
+            size_hint = size;
+            std::cout << "expr_" << i << " size: " << size << " has been saved" << std::endl;
         }
     }
 
+    std::cout << "Saving the exprs as one image onto the disk." << std::endl;
+    std::vector<SymEngine::hash_t> hashes;
+    for (const auto &e : exprs) {
+        hashes.push_back(e->hash());
+    }
+    const long first_sum = sum_of_exponents(*exprs[0]);
+    {
+        auto phase = Phase("image_save");
+        phase.SetUnits(node_count);
+        mmap_streambuf buf("exprs.img");
+        std::ostream os(&buf);
+        dump_image(os, exprs);
+        if (!os) {throw std::runtime_error("Cannot save exprs.img");}
+        std::cout << "exprs.img size: " << buf.size() << " has been saved" << std::endl;
+        buf.close();
+    }
+
     std::cout << "Checking for duplicates (symbols)" << std::endl;
     {
-        mem_usage_tracker mem_check_duplicates(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".check_duplicates.txt", true);
+        auto phase = Phase("check_duplicates");
         visitor_sym visitor;
         auto count_sym = visitor.apply({exprs[0]});
         std::cout << "Number of duplicate symbols found: " << count_sym << std::endl;
@@ -74,14 +138,56 @@ void bench01::Workload() {
 
     std::cout << "Wiping everything" << std::endl;
     {
-        mem_usage_tracker mem_wipe(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".wipe.txt", true);
+        auto phase = Phase("wipe");
         exprs.clear();
         id_to_sym.clear();
     }
 
+    const std::map<std::string, int> params = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    auto check_first_use = [&](long sum) {
+        if (sum != first_sum) {
+            std::cout << "Mismatch in the first use: " << sum << " vs " << first_sum << std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+    };
+
+    // Time to first use: from nothing in memory to the answer of a query on expr_0.
+    std::cout << "Opening the image of the exprs." << std::endl;
+    {
+        auto phase = Phase("image_load");
+        phase.SetUnits(node_count);
+        std::unique_ptr<expr_image> image;
+        {
+            timer_stats stats("bench01 first_use image", params);
+            timer_scope ts(stats);
+            image = std::make_unique<expr_image>("exprs.img");
+            check_first_use(sum_of_exponents(image->root(0)));
+        }
+        for (size_t i = 0; i < image->size(); i++) {
+            if (image->root(i).hash() != hashes[i]) {
+                std::cout << "Mismatch in the image at root " << i << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+        {
+            // The relocation pass, for the callers that need Basics: only the first expr is rebuilt.
+            timer_stats stats("bench01 materialize_first image", params);
+            timer_scope ts(stats);
+            if (image->materialize(0)->hash() != hashes[0]) {
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+        std::cout << "The image holds " << image->node_count() << " nodes in " << image->bytes() << " bytes" <<
+            std::endl;
+    }
+
     std::cout << "Loading the exprs from the disk." << std::endl;
     {
-        mem_usage_tracker mem_expr_load(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".expr_load.txt", true);
+        auto phase = Phase("expr_load");
+        phase.SetUnits(node_count);
+        timer_stats stats("bench01 first_use loads", params);
+        std::optional<timer_scope> ts;
+        ts.emplace(stats);
         for (size_t i = 0; i < cfg_N; i++) {
             auto file = std::ifstream("expr_" + std::to_string(i) + ".bin", std::ios::binary);
             if (!file) {throw std::runtime_error("Cannot open file");}
@@ -97,6 +203,10 @@ void bench01::Workload() {
 
             exprs.push_back(SymEngine::Basic::loads(serialized_data));
             file.close();
+            if (i == 0) {
+                check_first_use(sum_of_exponents(*exprs[0]));
+                ts.reset();
+            }
             std::cout << "Loaded expr_" << i << std::endl;
         }
 
@@ -106,7 +216,7 @@ void bench01::Workload() {
 
     std::cout << "Checking for duplicates (symbols) again" << std::endl;
     {
-        mem_usage_tracker mem_check_duplicates(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".check_duplicates.txt", true);
+        auto phase = Phase("check_duplicates");
         visitor_sym visitor;
         auto count_sym = visitor.apply({exprs[0], exprs[1]});
         std::cout << "Number of duplicate symbols found: " << count_sym << std::endl;
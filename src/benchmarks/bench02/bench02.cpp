@@ -0,0 +1,137 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench02.h"
+#include "utils/vec_serialization.h"
+#include "utils/visitor_sym.h"
+
+
+void bench02::Preparation() {
+    gen.make_symbols();
+}
+
+SymEngine::vec_basic bench02::Generate() {
+    return gen.generate(cfg_N);
+}
+
+void bench02::RunSuite(const std::string& tag) {
+    const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    const std::string t = tag.empty() ? "" : tag + "_";
+    auto heap = []() {
+        return static_cast<double>(phase_profiler::read_memory_counters().heap_in_use_bytes) / 1048576.0;
+    };
+
+    SymEngine::vec_basic exprs;
+    std::vector<SymEngine::hash_t> hashes;
+    const double heap_before_gen = heap();
+    std::cout << "Generating " << cfg_N << " " << tag << " expressions of length " << cfg_L << " and power " << cfg_P <<
+        std::endl;
+    {
+        auto phase = Phase(t + "expr_gen");
+        exprs = Generate();
+    }
+    const double footprint_gen = heap() - heap_before_gen;
+    const size_t nodes_gen = count_unique_nodes(exprs);
+    for (auto &e : exprs) {
+        hashes.push_back(e->hash());
+    }
+
+    size_t bytes_per_expr = 0, bytes_vec = 0;
+    std::cout << "Saving the exprs onto the disk, one by one." << std::endl;
+    {
+        auto phase = Phase(t + "save_per_expr");
+        timer_stats stats(name + " " + t + "save per-expr", pairs);
+        for (size_t i = 0; i < exprs.size(); i++) {
+            timer_scope ts(stats);
+            auto data = exprs[i]->dumps();
+            write_blob(t + "expr_" + std::to_string(i) + ".bin", data);
+            bytes_per_expr += data.size();
+        }
+    }
+    std::cout << "Saving the exprs onto the disk, as one vec_basic." << std::endl;
+    {
+        auto phase = Phase(t + "save_vec");
+        timer_stats stats(name + " " + t + "save vec_basic", pairs);
+        timer_scope ts(stats);
+        auto data = dumps_vec(exprs);
+        write_blob(t + "exprs.bin", data);
+        bytes_vec = data.size();
+    }
+
+    std::cout << "Wiping everything" << std::endl;
+    const size_t count = exprs.size();
+    exprs.clear();
+
+    auto verify = [&](const SymEngine::vec_basic& loaded, const std::string& how) {
+        if (loaded.size() != count) {
+            throw std::runtime_error("Loaded " + std::to_string(loaded.size()) + " exprs " + how);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (loaded[i]->hash() != hashes[i]) {
+                std::cout << "Mismatch in serialization at index " << i << " " << how << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+    };
+
+    double footprint_per_expr, footprint_vec;
+    size_t nodes_per_expr, nodes_vec;
+    std::cout << "Loading the exprs from the disk, one by one." << std::endl;
+    {
+        const double heap_before = heap();
+        SymEngine::vec_basic loaded;
+        {
+            auto phase = Phase(t + "load_per_expr");
+            timer_stats stats(name + " " + t + "load per-expr", pairs);
+            for (size_t i = 0; i < count; i++) {
+                auto data = read_blob(t + "expr_" + std::to_string(i) + ".bin");
+                timer_scope ts(stats);
+                loaded.push_back(SymEngine::Basic::loads(data));
+            }
+        }
+        footprint_per_expr = heap() - heap_before;
+        nodes_per_expr = count_unique_nodes(loaded);
+        verify(loaded, "per-expr");
+    }
+    std::cout << "Loading the exprs from the disk, as one vec_basic." << std::endl;
+    {
+        const double heap_before = heap();
+        SymEngine::vec_basic loaded;
+        {
+            auto phase = Phase(t + "load_vec");
+            auto data = read_blob(t + "exprs.bin");
+            timer_stats stats(name + " " + t + "load vec_basic", pairs);
+            timer_scope ts(stats);
+            loaded = loads_vec(data);
+        }
+        footprint_vec = heap() - heap_before;
+        nodes_vec = count_unique_nodes(loaded);
+        verify(loaded, "vec_basic");
+    }
+
+    std::cout << "============================================" << std::endl;
+    std::cout << "Suite " << name << " " << tag << " with N=" << cfg_N << " L=" << cfg_L << " P=" << cfg_P << std::endl;
+    std::cout << "> Heap after generation (MB):\t" << footprint_gen << ", unique nodes: " << nodes_gen << std::endl;
+    std::cout << "> per-expr:  \t" << bytes_per_expr << " bytes, heap after load (MB): " << footprint_per_expr <<
+        " (x" << footprint_per_expr / footprint_gen << "), unique nodes: " << nodes_per_expr << std::endl;
+    std::cout << "> vec_basic: \t" << bytes_vec << " bytes, heap after load (MB): " << footprint_vec <<
+        " (x" << footprint_vec / footprint_gen << "), unique nodes: " << nodes_vec << std::endl;
+    std::cout << "============================================" << std::endl;
+}
+
+/**
+ * This benchmark constructs N number of exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * and compares saving/loading them one by one through Basic::dumps()/loads() with saving/loading the whole vec_basic
+ * through one archive.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *
+ */
+void bench02::Workload() {
+    RunSuite("");
+}
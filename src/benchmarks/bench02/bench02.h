@@ -0,0 +1,45 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+/**
+ * The vector serialization suite: bench02 itself and the variants that only change how the exprs are generated
+ * (bench03: expanded exprs, bench04: deep vs wide exprs).
+ */
+class bench02: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    sum_of_powers gen;
+
+    bench02(const std::string& name, size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        benchmark_base(name),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), gen(cfg_L, cfg_P)
+    {}
+
+    /**
+     * @return The cfg_N exprs to be serialized. Timed and tracked as the `expr_gen` phase of the suite.
+     */
+    virtual SymEngine::vec_basic Generate();
+
+    /**
+     * Generates the exprs, saves them per-expr with dumps() and as a whole with dumps_vec(), wipes them, loads them
+     * back both ways and reports the size, the timings and the memory amplification of each way.
+     * @param tag Distinguishes the files and the phases of several runs of the suite within one benchmark.
+     */
+    void RunSuite(const std::string& tag);
+
+public:
+    bench02(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        bench02("bench02", cfg_N, cfg_L, cfg_P)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
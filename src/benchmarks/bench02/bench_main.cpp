@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench02/bench02.h"
+
+int main() {
+    bench02 b(16, 1024*2, 5);
+    b.Run();
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench02 --file mem_usage_bench02.txt | tee /dev/tty
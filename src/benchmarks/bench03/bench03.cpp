@@ -0,0 +1,16 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench03.h"
+#include "symengine/expand.h"
+
+SymEngine::vec_basic bench03::Generate() {
+    auto exprs = bench02::Generate();
+    timer_stats stats(name + " expand", {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}});
+    for (auto &e : exprs) {
+        timer_scope ts(stats);
+        e = SymEngine::expand(e);
+    }
+    return exprs;
+}
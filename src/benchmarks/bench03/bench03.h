@@ -0,0 +1,21 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "bench02/bench02.h"
+
+/**
+ * The vector serialization suite of bench02 on expanded exprs. Expanding multiplies the number of terms (and of the
+ * nodes shared between the exprs), so keep cfg_L and cfg_P small.
+ */
+class bench03: public bench02 {
+protected:
+    SymEngine::vec_basic Generate() override;
+
+public:
+    bench03(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        bench02("bench03", cfg_N, cfg_L, cfg_P)
+    {}
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench03/bench03.h"
+
+int main() {
+    bench03 b(4, 64, 5);
+    b.Run();
+
+    return 0;
+}
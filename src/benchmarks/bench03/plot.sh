@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench03 --file mem_usage_bench03.txt | tee /dev/tty
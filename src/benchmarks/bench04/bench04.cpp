@@ -0,0 +1,39 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench04.h"
+#include "symengine/add.h"
+#include "symengine/mul.h"
+#include "symengine/pow.h"
+#include "symengine/integer.h"
+
+/**
+ * The deep exprs are built as:
+ *  e = a_0
+ *  e = ((e + b_k)^get_random_integer(min=1, max=P)) * c_k for k in range(L)
+ * so every level nests the previous one, unlike the flat sums whose depth does not depend on L.
+ */
+SymEngine::vec_basic bench04::Generate() {
+    if (cfg_shape == shape::WIDE) {
+        return bench02::Generate();
+    }
+    SymEngine::vec_basic exprs;
+    exprs.reserve(cfg_N);
+    for (size_t i = 0; i < cfg_N; i++) {
+        SymEngine::RCP<const SymEngine::Basic> e = gen.sym(0, 0);
+        for (size_t k = 0; k < cfg_L; k++) {
+            auto p = SymEngine::integer(sum_of_powers::get_random_integer(1, cfg_P));
+            e = SymEngine::mul(SymEngine::pow(SymEngine::add(e, gen.sym(1, k)), p), gen.sym(2, k));
+        }
+        exprs.push_back(e);
+    }
+    return exprs;
+}
+
+void bench04::Workload() {
+    cfg_shape = shape::WIDE;
+    RunSuite("wide");
+    cfg_shape = shape::DEEP;
+    RunSuite("deep");
+}
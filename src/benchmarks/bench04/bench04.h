@@ -0,0 +1,27 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "bench02/bench02.h"
+
+/**
+ * The vector serialization suite of bench02 on two shapes of exprs with about the same number of nodes:
+ *  - wide: the flat sums of powers of bench02.
+ *  - deep: a chain of cfg_L nested operations, which stresses the recursion of the (de)serializer.
+ */
+class bench04: public bench02 {
+protected:
+    enum class shape {WIDE, DEEP};
+    shape cfg_shape = shape::WIDE;
+
+    SymEngine::vec_basic Generate() override;
+
+public:
+    bench04(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        bench02("bench04", cfg_N, cfg_L, cfg_P)
+    {}
+
+    void Workload() override;
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench04/bench04.h"
+
+int main() {
+    bench04 b(16, 1024, 5);
+    b.Run();
+
+    return 0;
+}
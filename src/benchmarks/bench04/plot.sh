@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench04 --file mem_usage_bench04.txt | tee /dev/tty
@@ -0,0 +1,268 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
+#include "CFileWriterBase.h"
+#include "symengine/add.h"
+#include "symengine/mul.h"
+#include <cereal/types/vector.hpp>
+
+/**
+ * A front-end of CFileWriterBase that stores the successive states of a RetID as diffs against their predecessor.
+ * A state that is an Add (or a Mul) like its predecessor is stored as a delta record: its coefficient, the entries of
+ * its dict that were added or changed, and the keys that were removed. Any other state, the first state of a RetID
+ * after the instance is created, every `keyframeInterval`-th state of a RetID, and a state whose delta would be larger
+ * than half of its dict, are stored in full as keyframes.
+ *
+ * `Read(retId, idx)` walks back to the nearest keyframe through the headers of the records (`ReadField<0>()`, see
+ * CFileWriterBase) and replays the deltas on a single copy of the keyframe's dict, so the unchanged terms of the
+ * rebuilt state are the nodes of the keyframe. Reading a state costs at most `keyframeInterval` records; the last state
+ * read from every RetID is kept, so that a sequential read only replays one delta per state.
+ *
+ * The records are self-contained (a keyframe can be read without the records before it).
+ *
+ * Usage:
+ *  CDeltaFileWriter writer(dir, "name", 16);
+ *  const auto retId = writer.GenerateRetId();
+ *  writer.Append(retId, state);
+ *  auto state = writer.Read(retId, idx);
+ */
+class CDeltaFileWriter {
+public:
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    enum RecordKind : uint8_t {
+        KEYFRAME = 0,
+        DELTA_ADD,
+        DELTA_MUL
+    };
+
+    // (kind, depth: the number of deltas since the keyframe, payload: the state of a keyframe or the coefficient of a
+    // delta, the keys of the added and changed entries, their values, the removed keys)
+    using storage_t = CFileWriterBase<uint8_t, uint32_t, rcp_basic, SymEngine::vec_basic, SymEngine::vec_basic,
+        SymEngine::vec_basic>;
+
+    struct DeltaStats {
+        size_t keyframes = 0;
+        size_t deltas = 0;
+        // The dict entries written by the deltas (added or changed, and removed).
+        size_t deltaEntries = 0;
+        // The dict entries the same states would have written in full.
+        size_t fullEntries = 0;
+        size_t reads = 0;
+        size_t recordsRead = 0;
+        // The largest number of records read to rebuild a single state.
+        size_t maxRecordsPerRead = 0;
+
+        double ReadAmplification() const {
+            return reads == 0 ? 0.0 : static_cast<double>(recordsRead) / static_cast<double>(reads);
+        }
+    };
+
+private:
+    struct LastState {
+        size_t index = 0;
+        rcp_basic state;
+        uint32_t depth = 0;
+    };
+
+    storage_t m_oStorage;
+    const uint32_t m_iKeyframeInterval;
+    std::mutex m_oMutex;
+    // The last appended and the last read state of every RetID.
+    std::unordered_map<size_t, LastState> m_mLastAppended, m_mLastRead;
+    DeltaStats m_oStats;
+
+    static size_t DictSize(const SymEngine::Basic &x) {
+        if (SymEngine::is_a<SymEngine::Add>(x)) {
+            return SymEngine::down_cast<const SymEngine::Add &>(x).get_dict().size();
+        }
+        if (SymEngine::is_a<SymEngine::Mul>(x)) {
+            return SymEngine::down_cast<const SymEngine::Mul &>(x).get_dict().size();
+        }
+        return 1;
+    }
+
+    /**
+     * Fills the changes of dict `cur` against dict `prev`, and returns false if they are too many for a delta.
+     */
+    template<typename Dict>
+    static bool Diff(const Dict &prev, const Dict &cur, SymEngine::vec_basic &keys, SymEngine::vec_basic &values,
+                     SymEngine::vec_basic &removed) {
+        const size_t limit = cur.size() / 2;
+        for (const auto &[key, value]: cur) {
+            const auto it = prev.find(key);
+            if (it == prev.end() || !SymEngine::eq(*it->second, *value)) {
+                keys.push_back(key);
+                values.push_back(value);
+            }
+            if (keys.size() > limit) {
+                return false;
+            }
+        }
+        for (const auto &[key, value]: prev) {
+            if (cur.find(key) == cur.end()) {
+                removed.push_back(key);
+            }
+            if (keys.size() + removed.size() > limit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Dict>
+    static void Apply(Dict &dict, const SymEngine::vec_basic &keys, const SymEngine::vec_basic &values,
+                      const SymEngine::vec_basic &removed) {
+        for (const auto &key: removed) {
+            dict.erase(key);
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            if constexpr (std::is_same_v<Dict, SymEngine::umap_basic_num>) {
+                dict[keys[i]] = SymEngine::rcp_static_cast<const SymEngine::Number>(values[i]);
+            } else {
+                dict[keys[i]] = values[i];
+            }
+        }
+    }
+
+public:
+    CDeltaFileWriter(
+        const std::string &basePath,
+        const std::string &name,
+        uint32_t keyframeInterval = 16,
+        bool load_if_exists = false,
+        bool dbg = false
+    ) : m_oStorage(basePath, name, load_if_exists, dbg, true),
+        m_iKeyframeInterval(std::max<uint32_t>(1, keyframeInterval)) {
+    }
+
+    size_t GenerateRetId() {
+        return m_oStorage.GenerateRetId();
+    }
+
+    size_t GetElementCount(size_t retId) {
+        return m_oStorage.GetElementCount(retId);
+    }
+
+    size_t GetFileSize() {
+        return m_oStorage.GetFileSize();
+    }
+
+    DeltaStats GetDeltaStats() {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        return m_oStats;
+    }
+
+    void Nuke() {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        m_mLastAppended.clear();
+        m_mLastRead.clear();
+        m_oStorage.Nuke();
+    }
+
+    /**
+     * @return The index of the state within the RetID.
+     */
+    size_t Append(size_t retId, const rcp_basic &state) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        const auto it = m_mLastAppended.find(retId);
+        SymEngine::vec_basic keys, values, removed;
+        uint8_t kind = KEYFRAME;
+        uint32_t depth = 0;
+        rcp_basic payload = state;
+        if (it != m_mLastAppended.end() && it->second.depth + 1 < m_iKeyframeInterval) {
+            const auto &prev = *it->second.state;
+            if (SymEngine::is_a<SymEngine::Add>(prev) && SymEngine::is_a<SymEngine::Add>(*state)) {
+                const auto &p = SymEngine::down_cast<const SymEngine::Add &>(prev);
+                const auto &c = SymEngine::down_cast<const SymEngine::Add &>(*state);
+                if (Diff(p.get_dict(), c.get_dict(), keys, values, removed)) {
+                    kind = DELTA_ADD;
+                    payload = c.get_coef();
+                }
+            } else if (SymEngine::is_a<SymEngine::Mul>(prev) && SymEngine::is_a<SymEngine::Mul>(*state)) {
+                const auto &p = SymEngine::down_cast<const SymEngine::Mul &>(prev);
+                const auto &c = SymEngine::down_cast<const SymEngine::Mul &>(*state);
+                if (Diff(p.get_dict(), c.get_dict(), keys, values, removed)) {
+                    kind = DELTA_MUL;
+                    payload = c.get_coef();
+                }
+            }
+        }
+        if (kind == KEYFRAME) {
+            keys.clear();
+            values.clear();
+            removed.clear();
+            m_oStats.keyframes++;
+        } else {
+            depth = it->second.depth + 1;
+            m_oStats.deltas++;
+            m_oStats.deltaEntries += keys.size() + removed.size();
+        }
+        m_oStats.fullEntries += DictSize(*state);
+
+        const size_t index = m_oStorage.Append(retId, {kind, depth, payload, keys, values, removed});
+        m_mLastAppended[retId] = {index, state, depth};
+        return index;
+    }
+
+    rcp_basic Read(size_t retId, size_t stateIndex) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        // The deltas are replayed from the nearest keyframe, or from the last state read if it is after it.
+        const uint32_t depth = m_oStorage.ReadField<1>(retId, stateIndex);
+        const size_t keyframe = stateIndex - depth;
+        const auto cached = m_mLastRead.find(retId);
+        const bool fromCache = cached != m_mLastRead.end() && cached->second.index >= keyframe &&
+                               cached->second.index <= stateIndex;
+
+        size_t first;
+        rcp_basic state;
+        size_t records = 0;
+        if (fromCache) {
+            first = cached->second.index + 1;
+            state = cached->second.state;
+        } else {
+            state = std::get<2>(m_oStorage.Read(retId, keyframe));
+            first = keyframe + 1;
+            records++;
+        }
+
+        if (first <= stateIndex) {
+            // A chain of deltas never changes kind: a delta is only written against a predecessor of its own kind.
+            const auto kind = m_oStorage.ReadField<0>(retId, first);
+            SymEngine::RCP<const SymEngine::Number> coef;
+            SymEngine::umap_basic_num addDict;
+            SymEngine::map_basic_basic mulDict;
+            if (kind == DELTA_ADD) {
+                addDict = SymEngine::down_cast<const SymEngine::Add &>(*state).get_dict();
+            } else {
+                mulDict = SymEngine::down_cast<const SymEngine::Mul &>(*state).get_dict();
+            }
+            for (size_t i = first; i <= stateIndex; i++) {
+                const auto record = m_oStorage.Read(retId, i);
+                records++;
+                coef = SymEngine::rcp_static_cast<const SymEngine::Number>(std::get<2>(record));
+                if (kind == DELTA_ADD) {
+                    Apply(addDict, std::get<3>(record), std::get<4>(record), std::get<5>(record));
+                } else {
+                    Apply(mulDict, std::get<3>(record), std::get<4>(record), std::get<5>(record));
+                }
+            }
+            state = kind == DELTA_ADD ? SymEngine::Add::from_dict(coef, std::move(addDict))
+                                      : SymEngine::Mul::from_dict(coef, std::move(mulDict));
+        }
+
+        m_mLastRead[retId] = {stateIndex, state, depth};
+        m_oStats.reads++;
+        m_oStats.recordsRead += records;
+        m_oStats.maxRecordsPerRead = std::max(m_oStats.maxRecordsPerRead, records);
+        return state;
+    }
+};
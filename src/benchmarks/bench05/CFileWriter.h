@@ -2,42 +2,38 @@
 // Created by saleh on 12/29/24.
 //
 
-// This is a base class for CFileWriterX classes.
-
 #pragma once
 
 #include "CFileWriterBase.h"
-#include "symengine/streaming_deserializer.h"
-#include "symengine/streaming_serializer.h"
-
-class CFileWriter : public CFileWriterBase {
-protected:
-    SymEngine::streaming_serializer se_serializer;
 
+/**
+ * A streaming front-end of CFileWriterBase: the elements are written as self-contained records as soon as they are
+ * produced, and `Stream()` takes them by value so that the caller's copy is released right after it is written.
+ * A generate-and-stream pipeline therefore holds one expr (and the nodes it shares with the next ones, such as the
+ * symbols) at a time instead of all of them, at the cost of writing the shared nodes once per record.
+ *
+ * Usage:
+ *  CFileWriter<size_t, RCP<const Basic>> writer(dir, "name", false);
+ *  const auto retId = writer.GenerateRetId();
+ *  for (...) { writer.Stream(retId, i, build_expr(i)); }
+ */
+template<typename... Types>
+class CFileWriter : public CFileWriterBase<Types...> {
 public:
-    // Constructor that takes the file path to allocate
-    explicit CFileWriter(const std::string& filePath)
-        : CFileWriterBase(filePath) {
-
-    }
-
-    // Destructor: Print the partition sizes and offsets
-    ~CFileWriter() {
+    CFileWriter(
+        const std::string &basePath,
+        const std::string &name,
+        bool load_if_exists,
+        bool dbg = false,
+        bool dedup = false
+    ) : CFileWriterBase<Types...>(basePath, name, load_if_exists, dbg, true, dedup) {
     }
 
-    // Create a new partition and return an ostream for it
-    std::ostream& createPartition() {
-        return CFileWriterBase::createPartition();
-    }
-
-    // Change the head of the stream to the start of a given partition index
-    void seekToPartitionStart(int partitionIndex) {
-        CFileWriterBase::seekToPartitionStart(partitionIndex);
-    }
-
-    // Print the partition sizes and offsets
-    void printPartitionInfo() {
-        CFileWriterBase::printPartitionInfo();
+    /**
+     * Appends one element and drops it. Move the last reference of an expr in to have it freed before the next one is
+     * generated.
+     */
+    void Stream(size_t retId, Types... data) {
+        this->Append(retId, std::tuple<Types...>(std::move(data)...));
     }
 };
-
@@ -8,15 +8,34 @@
 
 #include "symengine/basic.h"
 #include "symengine/serialize-cereal.h"
+#include "symengine/symengine_config.h"
 #include <iostream>
 
 #include <fstream>
 #include <vector>
 #include <stdexcept>
 #include <iomanip>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
 
 #include "json/json.h"
 #include <boost/filesystem.hpp>
+#include "utils/batch_reader.h"
 
 
 /**
@@ -47,20 +66,58 @@
  *  - Read 1 element from RetID 0, element offset 1.
  *
  * We only have 1 file, so all the offsets for (retID, elementIndex) should be tracked and stored.
+ *
+ * By default all the elements go through a single pair of archives, so a node that was written by an earlier element is
+ * only referenced by the later ones. That keeps the file small, but:
+ *  - The save archive identifies the nodes by their address, so the written exprs must stay alive as long as the
+ *    instance is used for writing. Otherwise a new node allocated at the address of a released one is written as a
+ *    reference to the released one.
+ *  - An element can only be read after the elements it references were read.
+ * With `selfContained`, every element is written and read through its own archive instead. The nodes shared between
+ * the elements are written once per element, but the elements can be released right after they are appended and can be
+ * read in any order.
+ *
+ * `Scan()` walks a range of the elements of a RetID with read-ahead, see CScan. `ReadMany()` reads a batch of
+ * scattered elements with batched I/O and parallel deserialization.
+ *
+ * With `dedup` (self-contained only), the archived fields of the elements (the RCPs) are content-addressed: they are
+ * written as a separate payload record, and the record of every element is a stub made of its header and the id of
+ * its payload. An element whose archived fields serialize to the bytes of a payload already in the file only writes its
+ * stub, so the repeated states of a RetID are stored once even though their indices differ. The payloads are looked up
+ * by the 64-bit FNV-1a fingerprint of their bytes, and a hit is confirmed by comparing the size and the bytes with the
+ * stored payload, so a collision only costs a lookup. The payload table is kept in the json file along with the
+ * offsets, see `GetDedupStats()`.
+ *
+ * Every record starts with a fixed-size header holding the trivially copyable fields of `Types...` (e.g. the size_t
+ * index), copied as they are in memory (so the file is only portable between machines of the same endianness). Only
+ * the other fields (the RCPs) go through the archive. `ReadField<I>()` reads one field of an element: a header field
+ * costs a read of its few bytes, without touching the archive, so scanning the metadata of a RetID is nearly free.
+ *
+ * `Erase()` and `Truncate()` only record tombstones in the index; the space of the dead records is reclaimed by
+ * `Compact()` (self-contained only), which copies the live records into a new file while the instance keeps serving
+ * reads and appends, and then switches the file and the index over.
  */
 template<typename... Types>
 class CFileWriterBase {
 protected:
-    const std::string m_sFormat = "RawFmt01";
+    const std::string m_sFormat;
     const std::string m_sName, m_sBasePath, m_sFileBin, m_sFileJson;
     const bool m_bDebug;
+    const bool m_bSelfContained;
+    const bool m_bDedup;
 
     std::mutex m_oMutexOffsets;
     std::unordered_map<size_t, std::vector<std::streampos> > m_mOffsets;
+    // Tombstones: retId -> the number of its leading elements that are still live, 0 once erased. The dead elements
+    // stay in m_mOffsets until the next append to the retId or the next compaction.
+    std::unordered_map<size_t, size_t> m_mTombstones;
+    // The offsets of the dead records that were dropped from m_mOffsets, so that the extent of the records before them
+    // is still known.
+    std::vector<std::streamoff> m_vDeadOffsets;
+    std::mutex m_oMutexCompaction;
 
     std::streampos m_lOffset = 0;
-    std::mutex m_oMutexRetId;
-    size_t m_lRetId = 0;
+    std::atomic<size_t> m_lRetId{0};
     bool m_bNuked = false;
 
     Json::Value m_oFileJson;
@@ -69,24 +126,161 @@ protected:
     std::unique_ptr<SymEngine::RCPBasicAwareOutputArchive<cereal::PortableBinaryOutputArchive> > m_oArchiveSave;
     std::unique_ptr<SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> > m_oArchiveLoad;
 
+    struct DedupRecord {
+        std::streamoff offset;
+        // 0 once the payload was dropped by Compact(); its id is not reused.
+        size_t size;
+        uint64_t fingerprint;
+    };
+
+    // The payloads of the dedup mode, by id.
+    std::vector<DedupRecord> m_vPayloads;
+    // fingerprint -> the ids of the payloads with that fingerprint (more than one only on a collision).
+    std::unordered_map<uint64_t, std::vector<uint64_t> > m_mDedupIndex;
+    // The offset of every stub of the dedup mode -> the id of its payload.
+    std::unordered_map<std::streamoff, uint64_t> m_mStubPayload;
+
     class FileError : public std::runtime_error {
     public:
         FileError(const std::string &msg) : std::runtime_error(msg) {
         }
     };
 
+    template<typename T>
+    static constexpr bool IsFixed = std::is_trivially_copyable_v<T>;
+
+    // The size of the header and the offset of every trivially copyable field in it.
+    static constexpr size_t FIXED_BYTES = (size_t(0) + ... + (IsFixed<Types> ? sizeof(Types) : 0));
+    static constexpr std::array<size_t, sizeof...(Types)> FIXED_OFFSETS = []() {
+        std::array<size_t, sizeof...(Types)> offsets{};
+        size_t offset = 0, i = 0;
+        ((offsets[i++] = offset, offset += IsFixed<Types> ? sizeof(Types) : 0), ...);
+        return offsets;
+    }();
+    // The size of the buffer that Compact() copies the records through.
+    static constexpr size_t COMPACTION_BUFFER_BYTES = 1 << 20;
+    // The size of the record of an element in the dedup mode: its header and the id of its payload.
+    static constexpr size_t STUB_BYTES = FIXED_BYTES + sizeof(uint64_t);
+
+    template<typename T>
+    static auto ArchivedRef(T &field) {
+        if constexpr (IsFixed<std::remove_const_t<T> >) {
+            return std::tuple<>();
+        } else {
+            return std::tuple<T &>(field);
+        }
+    }
+
+    static void WriteFixed(std::ostream &os, const Types &... data) {
+        std::array<char, FIXED_BYTES> header{};
+        size_t i = 0;
+        ([&](const auto &field) {
+            using field_t = std::decay_t<decltype(field)>;
+            if constexpr (IsFixed<field_t>) {
+                std::memcpy(header.data() + FIXED_OFFSETS[i], &field, sizeof(field_t));
+            }
+            i++;
+        }(data), ...);
+        os.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    static void ReadFixed(std::istream &is, std::tuple<Types...> &data) {
+        std::array<char, FIXED_BYTES> header{};
+        is.read(header.data(), static_cast<std::streamsize>(header.size()));
+        if (!is.good()) {
+            throw FileError("Failed to read the header of the element");
+        }
+        std::apply([&](Types &... fields) {
+            size_t i = 0;
+            ([&](auto &field) {
+                using field_t = std::decay_t<decltype(field)>;
+                if constexpr (IsFixed<field_t>) {
+                    std::memcpy(&field, header.data() + FIXED_OFFSETS[i], sizeof(field_t));
+                }
+                i++;
+            }(fields), ...);
+        }, data);
+    }
+
+    /**
+     * Passes the fields that are not in the header to the archive.
+     */
+    template<typename Archive>
+    static void WriteArchived(Archive &archive, const Types &... data) {
+        auto archived = std::tuple_cat(ArchivedRef(data)...);
+        if constexpr (std::tuple_size_v<decltype(archived)> > 0) {
+            std::apply(archive, archived);
+        }
+    }
+
+    template<typename Archive>
+    static void ReadArchived(Archive &archive, std::tuple<Types...> &data) {
+        std::apply([&](Types &... fields) {
+            auto archived = std::tuple_cat(ArchivedRef(fields)...);
+            if constexpr (std::tuple_size_v<decltype(archived)> > 0) {
+                std::apply(archive, archived);
+            }
+        }, data);
+    }
+
+public:
+    struct DedupStats {
+        size_t appends = 0;
+        // The appends that were resolved to an existing record.
+        size_t hits = 0;
+        // The payloads and the stubs.
+        size_t bytesWritten = 0;
+        // The payload bytes the hits did not write.
+        size_t bytesSaved = 0;
+        // The time spent fingerprinting, looking up and confirming the records.
+        double hashSeconds = 0;
+
+        double DedupRatio() const {
+            return appends == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(appends);
+        }
+
+        double HashNanosPerAppend() const {
+            return appends == 0 ? 0.0 : hashSeconds * 1e9 / static_cast<double>(appends);
+        }
+    };
+
+protected:
+    DedupStats m_oDedupStats;
+
 public:
+    struct CompactionStats {
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+        size_t recordsCopied = 0;
+        // The pread/pwrite runs the records were copied in: the adjacent live records are copied together.
+        size_t runsCopied = 0;
+        size_t bytesCopied = 0;
+        double seconds = 0;
+
+        double ThroughputMBps() const {
+            return seconds == 0 ? 0.0 : static_cast<double>(bytesCopied) / 1e6 / seconds;
+        }
+    };
+
     CFileWriterBase(
         const std::string &basePath,
         const std::string &name,
         bool load_if_exists,
-        bool dbg = false
-    ) try : m_sBasePath(basePath),
+        bool dbg = false,
+        bool selfContained = false,
+        bool dedup = false
+    ) try : m_sFormat(dedup ? "RawFmt06" : selfContained ? "RawFmt04" : "RawFmt03"),
+            m_sBasePath(basePath),
             m_sFileBin(basePath + name + ".bin"),
             m_sFileJson(basePath + name + ".json"),
             m_sName(name),
-            m_bDebug(dbg) {
+            m_bDebug(dbg),
+            m_bSelfContained(selfContained),
+            m_bDedup(dedup) {
         try {
+            if (dedup && !selfContained) {
+                throw FileError("Deduplication requires self-contained elements");
+            }
             bool binExists = false;
             bool jsonExists = false;
 
@@ -134,12 +328,16 @@ public:
         }
     }
 
-    void Append(size_t retId, const std::tuple<Types...> &data) {
+    /**
+     * @return The index of the element within the RetID.
+     */
+    size_t Append(size_t retId, const std::tuple<Types...> &data) {
         try {
             std::lock_guard<std::mutex> lock(m_oMutexOffsets);
             std::apply([&](const Types &... args) {
                 _Append(retId, args...);
             }, data);
+            return m_mOffsets[retId].size() - 1;
         } catch (const std::exception &e) {
             throw FileError("Failed to append data: " + std::string(e.what()));
         }
@@ -151,34 +349,639 @@ public:
             if (m_mOffsets.find(retId) == m_mOffsets.end()) {
                 throw FileError("Invalid retId: " + std::to_string(retId));
             }
-            if (stateIndex >= m_mOffsets[retId].size()) {
+            if (stateIndex >= LiveCount(retId)) {
                 throw FileError("Invalid state index: " + std::to_string(stateIndex));
             }
 
             std::tuple<Types...> data;
-            std::apply([&](Types &... args) {
-                std::streampos addr = m_mOffsets[retId][stateIndex];
-                m_oFileBin.seekg(addr);
-                if (!m_oFileBin.good()) {
-                    throw FileError("Failed to seek to position in binary file");
-                }
-                (*m_oArchiveLoad)(args...);
-            }, data);
+            std::streampos addr = m_mOffsets[retId][stateIndex];
+            m_oFileBin.seekg(addr);
+            if (!m_oFileBin.good()) {
+                throw FileError("Failed to seek to position in binary file");
+            }
+            ReadFixed(m_oFileBin, data);
+            if (m_bDedup) {
+                m_oFileBin.seekg(PayloadOf(addr).offset);
+            }
+            if (m_bSelfContained) {
+                SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> archive(m_oFileBin);
+                ReadArchived(archive, data);
+            } else {
+                ReadArchived(*m_oArchiveLoad, data);
+            }
             return data;
         } catch (const std::exception &e) {
             throw FileError("Failed to read data: " + std::string(e.what()));
         }
     }
 
+    /**
+     * Reads field `I` of an element. A trivially copyable field is read from the header of the record alone; any other
+     * field costs the deserialization of all the archived fields of the element, as `Read()` does.
+     */
+    template<size_t I>
+    std::tuple_element_t<I, std::tuple<Types...> > ReadField(size_t retId, size_t stateIndex) {
+        using field_t = std::tuple_element_t<I, std::tuple<Types...> >;
+        if constexpr (IsFixed<field_t>) {
+            try {
+                std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+                if (m_mOffsets.find(retId) == m_mOffsets.end() || stateIndex >= LiveCount(retId)) {
+                    throw FileError("Invalid retId or state index: " + std::to_string(retId) + ", " +
+                                    std::to_string(stateIndex));
+                }
+                field_t value;
+                m_oFileBin.seekg(m_mOffsets[retId][stateIndex] + static_cast<std::streamoff>(FIXED_OFFSETS[I]));
+                m_oFileBin.read(reinterpret_cast<char *>(&value), sizeof(field_t));
+                if (!m_oFileBin.good()) {
+                    throw FileError("Failed to read the header of the element");
+                }
+                return value;
+            } catch (const std::exception &e) {
+                throw FileError("Failed to read field: " + std::string(e.what()));
+            }
+        } else {
+            return std::get<I>(Read(retId, stateIndex));
+        }
+    }
+
+    /**
+     * Reads a batch of elements, e.g. thousands of scattered (retId, stateIndex) pairs, and returns them in the order of
+     * `requests`:
+     *  - The distinct records of the batch are read through batch_reader: sorted by offset, the adjacent ones merged,
+     *    and submitted with a queue depth greater than one through io_uring (or one preadv after the other).
+     *  - The records are deserialized by `threads` workers (all the hardware threads if 0).
+     * In the dedup mode, the distinct payloads of the batch are read along with the stubs, once each.
+     * Only self-contained records can be deserialized out of order, so with the shared archive this is a `Read()` loop.
+     * Deserializing on several threads needs SymEngine to be built with `WITH_SYMENGINE_THREAD_SAFE=ON`, otherwise a
+     * single worker is used.
+     */
+    std::vector<std::tuple<Types...> > ReadMany(const std::vector<std::pair<size_t, size_t> > &requests,
+                                                size_t threads = 0) {
+        std::vector<std::tuple<Types...> > results;
+        results.reserve(requests.size());
+        if (!m_bSelfContained) {
+            for (const auto &[retId, stateIndex]: requests) {
+                results.push_back(Read(retId, stateIndex));
+            }
+            return results;
+        }
+        try {
+            // The byte ranges of the distinct records of the batch, the record of every request, the records of the
+            // elements among them, and the record that holds the archived fields of every record (a payload in the
+            // dedup mode, the record itself otherwise).
+            std::vector<std::pair<std::streamoff, std::streamoff> > ranges;
+            std::vector<size_t> recordOf(requests.size());
+            std::vector<size_t> elements, archivedIn;
+            {
+                std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+                const auto starts = SortedRecordStarts();
+                std::unordered_map<std::streamoff, size_t> seen;
+                for (size_t k = 0; k < requests.size(); k++) {
+                    const auto &[retId, stateIndex] = requests[k];
+                    if (m_mOffsets.find(retId) == m_mOffsets.end() || stateIndex >= LiveCount(retId)) {
+                        throw FileError("Invalid retId or state index: " + std::to_string(retId) + ", " +
+                                        std::to_string(stateIndex));
+                    }
+                    const auto first = static_cast<std::streamoff>(m_mOffsets[retId][stateIndex]);
+                    const auto [it, inserted] = seen.emplace(first, ranges.size());
+                    if (inserted) {
+                        const size_t record = ranges.size();
+                        ranges.emplace_back(first, RecordEnd(starts, first));
+                        elements.push_back(record);
+                        archivedIn.push_back(record);
+                        if (m_bDedup) {
+                            const auto &payload = PayloadOf(first);
+                            const auto [pit, pinserted] = seen.emplace(payload.offset, ranges.size());
+                            if (pinserted) {
+                                ranges.emplace_back(payload.offset,
+                                                    payload.offset + static_cast<std::streamoff>(payload.size));
+                                archivedIn.push_back(ranges.size() - 1);
+                            }
+                            archivedIn[record] = pit->second;
+                        }
+                    }
+                    recordOf[k] = it->second;
+                }
+                m_oFileBin.flush();
+            }
+
+            std::vector<std::string> buffers(ranges.size());
+            std::vector<batch_reader::request> reads;
+            reads.reserve(ranges.size());
+            for (size_t i = 0; i < ranges.size(); i++) {
+                buffers[i].resize(static_cast<size_t>(ranges[i].second - ranges[i].first));
+                reads.push_back({static_cast<uint64_t>(ranges[i].first), buffers[i].size(), &buffers[i][0]});
+            }
+            const int fd = open(m_sFileBin.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw FileError("Failed to open the binary file for the batch");
+            }
+            try {
+                batch_reader(64).read(fd, std::move(reads));
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+            close(fd);
+
+#ifndef WITH_SYMENGINE_THREAD_SAFE
+            threads = 1;
+#endif
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            threads = std::max<size_t>(1, std::min(threads, elements.size()));
+            std::vector<std::tuple<Types...> > records(ranges.size());
+            std::atomic<size_t> next{0};
+            std::mutex mutexError;
+            std::exception_ptr error;
+            auto work = [&]() {
+                try {
+                    for (size_t k = next.fetch_add(1); k < elements.size(); k = next.fetch_add(1)) {
+                        const size_t i = elements[k];
+                        std::istringstream iss(std::move(buffers[i]));
+                        ReadFixed(iss, records[i]);
+                        if (archivedIn[i] == i) {
+                            SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> archive(iss);
+                            ReadArchived(archive, records[i]);
+                        } else {
+                            // A payload can be shared by several elements of the batch, so it is copied.
+                            std::istringstream payload(buffers[archivedIn[i]]);
+                            SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> archive(payload);
+                            ReadArchived(archive, records[i]);
+                        }
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutexError);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            };
+            if (threads == 1) {
+                work();
+            } else {
+                std::vector<std::thread> workers;
+                for (size_t t = 0; t < threads; t++) {
+                    workers.emplace_back(work);
+                }
+                for (auto &w: workers) {
+                    w.join();
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+
+            for (const auto i: recordOf) {
+                results.push_back(records[i]);
+            }
+            return results;
+        } catch (const std::exception &e) {
+            throw FileError("Failed to read the batch: " + std::string(e.what()));
+        }
+    }
+
+    /**
+     * A sequential scan over the elements [begin, end) of a RetID, overlapping the I/O (and, for self-contained
+     * elements, the deserialization) with the work of the caller:
+     *  - The byte range of the scan is hinted to the kernel with `posix_fadvise(SEQUENTIAL | WILLNEED)`.
+     *  - With self-contained elements, a background thread reads and deserializes the next `prefetch` elements through
+     *    its own file descriptor into a bounded queue, while the caller consumes the current one.
+     *  - Otherwise the elements can only be deserialized in order through the shared load archive, so the background
+     *    thread only pulls the pages of the next `prefetch` elements into the page cache (`WILLNEED`), and `Next()`
+     *    deserializes through `Read()`.
+     * The instance must not be written to while a scan is running.
+     */
+    class CScan {
+    private:
+        CFileWriterBase &m_oOwner;
+        const size_t m_lRetId, m_lEnd, m_lPrefetch;
+        size_t m_lNext;
+        // The byte range [first, second) of every element of the scan, and of its payload in the dedup mode.
+        std::vector<std::pair<std::streamoff, std::streamoff> > m_vRanges, m_vPayloadRanges;
+        int m_iFd = -1;
+
+        std::mutex m_oMutex;
+        std::condition_variable m_oCondProduced, m_oCondConsumed;
+        std::deque<std::tuple<Types...> > m_qReady;
+        size_t m_lProduced = 0, m_lConsumed = 0;
+        bool m_bStop = false;
+        std::exception_ptr m_pError;
+        std::thread m_oThread;
+
+        std::string ReadBytes(size_t i, const std::pair<std::streamoff, std::streamoff> &range) {
+            const auto first = static_cast<off_t>(range.first);
+            std::string data(static_cast<size_t>(range.second - range.first), '\0');
+            size_t done = 0;
+            while (done < data.size()) {
+                const auto n = pread(m_iFd, &data[done], data.size() - done, first + static_cast<off_t>(done));
+                if (n <= 0) {
+                    throw FileError("Failed to read the element " + std::to_string(i) + " of the scan");
+                }
+                done += static_cast<size_t>(n);
+            }
+            return data;
+        }
+
+        void Produce() {
+            try {
+                for (size_t i = 0; i < m_vRanges.size(); i++) {
+                    {
+                        std::unique_lock<std::mutex> lock(m_oMutex);
+                        m_oCondConsumed.wait(lock, [&]() {
+                            return m_bStop || m_lProduced - m_lConsumed < m_lPrefetch;
+                        });
+                        if (m_bStop) {
+                            return;
+                        }
+                    }
+                    if (m_oOwner.m_bSelfContained) {
+                        std::istringstream iss(ReadBytes(i, m_vRanges[i]));
+                        std::tuple<Types...> data;
+                        ReadFixed(iss, data);
+                        if (m_oOwner.m_bDedup) {
+                            iss.str(ReadBytes(i, m_vPayloadRanges[i]));
+                        }
+                        SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> archive(iss);
+                        ReadArchived(archive, data);
+                        std::lock_guard<std::mutex> lock(m_oMutex);
+                        m_qReady.push_back(std::move(data));
+                    } else {
+                        const auto first = static_cast<off_t>(m_vRanges[i].first);
+                        posix_fadvise(m_iFd, first, static_cast<off_t>(m_vRanges[i].second) - first,
+                                      POSIX_FADV_WILLNEED);
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(m_oMutex);
+                        m_lProduced++;
+                    }
+                    m_oCondProduced.notify_one();
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_oMutex);
+                m_pError = std::current_exception();
+                m_bStop = true;
+                m_oCondProduced.notify_all();
+            }
+        }
+
+    public:
+        CScan(CFileWriterBase &owner, size_t retId, size_t begin, size_t end, size_t prefetch) :
+            m_oOwner(owner), m_lRetId(retId), m_lEnd(end), m_lPrefetch(std::max<size_t>(1, prefetch)),
+            m_lNext(begin) {
+            {
+                std::lock_guard<std::mutex> lock(owner.m_oMutexOffsets);
+                auto it = owner.m_mOffsets.find(retId);
+                if (it == owner.m_mOffsets.end() || end > owner.LiveCount(retId) || begin > end) {
+                    throw FileError("Invalid scan range of retId " + std::to_string(retId));
+                }
+                const auto starts = owner.SortedRecordStarts();
+                for (size_t i = begin; i < end; i++) {
+                    const auto first = static_cast<std::streamoff>(it->second[i]);
+                    m_vRanges.emplace_back(first, owner.RecordEnd(starts, first));
+                    if (owner.m_bDedup) {
+                        const auto &payload = owner.PayloadOf(first);
+                        m_vPayloadRanges.emplace_back(payload.offset,
+                                                      payload.offset + static_cast<std::streamoff>(payload.size));
+                    }
+                }
+                owner.m_oFileBin.flush();
+            }
+            m_iFd = open(owner.m_sFileBin.c_str(), O_RDONLY);
+            if (m_iFd < 0) {
+                throw FileError("Failed to open the binary file for the scan");
+            }
+            if (!m_vRanges.empty()) {
+                auto lo = m_vRanges.front().first, hi = m_vRanges.front().second;
+                for (const auto *ranges: {&m_vRanges, &m_vPayloadRanges}) {
+                    for (const auto &[first, last]: *ranges) {
+                        lo = std::min(lo, first);
+                        hi = std::max(hi, last);
+                    }
+                }
+                posix_fadvise(m_iFd, static_cast<off_t>(lo), static_cast<off_t>(hi - lo), POSIX_FADV_SEQUENTIAL);
+                posix_fadvise(m_iFd, static_cast<off_t>(lo), static_cast<off_t>(hi - lo), POSIX_FADV_WILLNEED);
+            }
+            m_oThread = std::thread(&CScan::Produce, this);
+        }
+
+        ~CScan() {
+            {
+                std::lock_guard<std::mutex> lock(m_oMutex);
+                m_bStop = true;
+            }
+            m_oCondConsumed.notify_all();
+            if (m_oThread.joinable()) {
+                m_oThread.join();
+            }
+            if (m_iFd >= 0) {
+                close(m_iFd);
+            }
+        }
+
+        CScan(const CScan &) = delete;
+        CScan &operator=(const CScan &) = delete;
+
+        /**
+         * Moves the next element of the scan into `out`.
+         * @return false once the scan is over.
+         */
+        bool Next(std::tuple<Types...> &out) {
+            if (m_lNext >= m_lEnd) {
+                return false;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_oMutex);
+                m_oCondProduced.wait(lock, [&]() {
+                    return m_pError || m_lProduced > m_lConsumed;
+                });
+                if (m_lProduced <= m_lConsumed && m_pError) {
+                    std::rethrow_exception(m_pError);
+                }
+                if (m_oOwner.m_bSelfContained) {
+                    out = std::move(m_qReady.front());
+                    m_qReady.pop_front();
+                }
+            }
+            if (!m_oOwner.m_bSelfContained) {
+                out = m_oOwner.Read(m_lRetId, m_lNext);
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_oMutex);
+                m_lConsumed++;
+            }
+            m_oCondConsumed.notify_one();
+            m_lNext++;
+            return true;
+        }
+
+        /**
+         * @return The index (within the RetID) of the element the next call to `Next()` returns.
+         */
+        size_t Position() const {
+            return m_lNext;
+        }
+    };
+
+    /**
+     * @param prefetch The number of elements read ahead of the caller.
+     */
+    std::unique_ptr<CScan> Scan(size_t retId, size_t begin, size_t end, size_t prefetch = 8) {
+        return std::make_unique<CScan>(*this, retId, begin, end, prefetch);
+    }
+
+    /**
+     * Flushes the binary file, e.g. before it is read through another file descriptor.
+     */
+    void Flush() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        m_oFileBin.flush();
+    }
+
+    /**
+     * Flushes the binary file and evicts its pages from the page cache, for cold-cache measurements. Only the clean
+     * pages can be evicted, hence the fdatasync().
+     */
+    void DropPageCache() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        m_oFileBin.flush();
+        const int fd = open(m_sFileBin.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw FileError("Failed to open the binary file");
+        }
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    const std::string &GetBinPath() const {
+        return m_sFileBin;
+    }
+
     size_t GetElementCount(size_t retId) {
         try {
             std::lock_guard<std::mutex> lock(m_oMutexOffsets);
-            return m_mOffsets[retId].size();
+            return m_mOffsets.count(retId) ? LiveCount(retId) : 0;
         } catch (const std::exception &e) {
             throw FileError("Failed to get element count: " + std::string(e.what()));
         }
     }
 
+    /**
+     * Drops all the elements of a RetID. Their records stay in the file until the next `Compact()`.
+     */
+    void Erase(size_t retId) {
+        Truncate(retId, 0);
+    }
+
+    /**
+     * Keeps the first `n` elements of a RetID. The next append to the RetID gets index `n`.
+     */
+    void Truncate(size_t retId, size_t n) {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        if (m_mOffsets.find(retId) == m_mOffsets.end()) {
+            throw FileError("Invalid retId: " + std::to_string(retId));
+        }
+        if (n > LiveCount(retId)) {
+            throw FileError("Cannot truncate retId " + std::to_string(retId) + " to " + std::to_string(n) +
+                            " elements, it only has " + std::to_string(LiveCount(retId)));
+        }
+        m_mTombstones[retId] = n;
+        debugPrint("Truncated retId: ", retId, " to ", n, " elements");
+    }
+
+    /**
+     * @return The number of bytes taken by the records that are referenced by a live element.
+     */
+    size_t GetLiveBytes() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        size_t bytes = 0;
+        for (const auto &[first, last]: LiveRecordRanges()) {
+            bytes += static_cast<size_t>(last - first);
+        }
+        return bytes;
+    }
+
+    /**
+     * @return The size of the binary file over the bytes of its live records.
+     */
+    double GetSpaceAmplification() {
+        const size_t live = GetLiveBytes();
+        return live == 0 ? 0.0 : static_cast<double>(GetFileSize()) / static_cast<double>(live);
+    }
+
+    /**
+     * Copies the live records into a new file and switches over to it:
+     *  - The live records are listed under the lock and are then copied without it, so that the reads and the appends
+     *    go on against the current file meanwhile.
+     *  - Under the lock again, the records appended in the meantime are copied as they are, the new file is renamed
+     *    over the current one and the offsets are remapped.
+     * A running CScan keeps reading the records of the file it was opened on.
+     * Only self-contained records can be moved, the records of the shared archive reference each other by position.
+     */
+    CompactionStats Compact() {
+        if (!m_bSelfContained) {
+            throw FileError("Compaction requires self-contained elements");
+        }
+        std::lock_guard<std::mutex> compactionLock(m_oMutexCompaction);
+        const auto t0 = std::chrono::steady_clock::now();
+        CompactionStats stats;
+        const std::string tmpPath = m_sFileBin + ".compact";
+
+        std::vector<std::pair<std::streamoff, std::streamoff> > live;
+        std::streamoff snapshotEnd;
+        {
+            std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+            m_oFileBin.flush();
+            live = LiveRecordRanges();
+            snapshotEnd = static_cast<std::streamoff>(m_lOffset);
+        }
+        stats.bytesBefore = static_cast<size_t>(snapshotEnd);
+
+        int src = open(m_sFileBin.c_str(), O_RDONLY);
+        int dst = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (src < 0 || dst < 0) {
+            if (src >= 0) {close(src);}
+            if (dst >= 0) {close(dst);}
+            throw FileError("Failed to open the files for compaction");
+        }
+        std::streamoff out = 0;
+        std::unordered_map<std::streamoff, std::streamoff> remap;
+        std::vector<char> buffer(COMPACTION_BUFFER_BYTES);
+        // Copies the records in file order, a run of adjacent records at a time, and remaps each one of them.
+        auto copyRecords = [&](const std::vector<std::pair<std::streamoff, std::streamoff> > &records) {
+            for (size_t k = 0; k < records.size();) {
+                const std::streamoff runFirst = records[k].first;
+                std::streamoff runLast = records[k].second;
+                remap[runFirst] = out;
+                size_t m = k + 1;
+                for (; m < records.size() && records[m].first == runLast; m++) {
+                    remap[records[m].first] = out + (records[m].first - runFirst);
+                    runLast = records[m].second;
+                }
+                CopyRange(src, dst, runFirst, runLast, out, buffer);
+                stats.recordsCopied += m - k;
+                stats.runsCopied++;
+                k = m;
+            }
+        };
+        try {
+            copyRecords(live);
+
+            std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+            m_oFileBin.flush();
+            // A dedup hit may have revived a record that was dead at the snapshot.
+            std::vector<std::pair<std::streamoff, std::streamoff> > revived;
+            for (const auto &range: LiveRecordRanges()) {
+                if (range.first < snapshotEnd && remap.find(range.first) == remap.end()) {
+                    revived.push_back(range);
+                }
+            }
+            copyRecords(revived);
+            const std::streamoff tailStart = out;
+            CopyRange(src, dst, snapshotEnd, static_cast<std::streamoff>(m_lOffset), out, buffer);
+            if (fsync(dst) != 0) {
+                throw FileError("Failed to sync the compacted file");
+            }
+            close(src);
+            close(dst);
+            src = dst = -1;
+
+            if (std::rename(tmpPath.c_str(), m_sFileBin.c_str()) != 0) {
+                throw FileError("Failed to replace the binary file with the compacted one");
+            }
+            m_oFileBin.close();
+            m_oFileBin.open(m_sFileBin, std::ios::in | std::ios::out | std::ios::binary);
+            if (!m_oFileBin.is_open()) {
+                throw FileError("Failed to reopen the compacted binary file");
+            }
+
+            auto moved = [&](std::streamoff o) {
+                return o >= snapshotEnd ? o - snapshotEnd + tailStart : remap.at(o);
+            };
+            // The dead records that are in the new file stay dead there: the ones appended after the snapshot, copied
+            // with the tail, and the ones that were live at the snapshot and were truncated or erased before the
+            // switch. Otherwise their bytes would count as the end of the record before them and would never be
+            // reclaimed.
+            auto copied = [&](std::streamoff o) {
+                return o >= snapshotEnd || remap.find(o) != remap.end();
+            };
+            std::vector<std::streamoff> dead;
+            for (const auto o: m_vDeadOffsets) {
+                if (copied(o)) {
+                    dead.push_back(moved(o));
+                }
+            }
+            for (auto it = m_mOffsets.begin(); it != m_mOffsets.end();) {
+                auto &addrList = it->second;
+                const size_t n = LiveCount(it->first);
+                for (size_t i = n; i < addrList.size(); i++) {
+                    if (copied(static_cast<std::streamoff>(addrList[i]))) {
+                        dead.push_back(moved(static_cast<std::streamoff>(addrList[i])));
+                    }
+                }
+                addrList.resize(n);
+                for (auto &addr: addrList) {
+                    addr = static_cast<std::streampos>(moved(static_cast<std::streamoff>(addr)));
+                }
+                it = n == 0 && m_mTombstones.count(it->first) ? m_mOffsets.erase(it) : std::next(it);
+            }
+            m_mTombstones.clear();
+            m_vDeadOffsets = std::move(dead);
+
+            if (m_bDedup) {
+                std::unordered_map<std::streamoff, uint64_t> stubs;
+                for (const auto &[o, id]: m_mStubPayload) {
+                    if (copied(o)) {
+                        stubs[moved(o)] = id;
+                    }
+                }
+                m_mStubPayload = std::move(stubs);
+                for (uint64_t id = 0; id < m_vPayloads.size(); id++) {
+                    auto &payload = m_vPayloads[id];
+                    if (payload.size == 0) {
+                        continue;
+                    }
+                    if (payload.offset < snapshotEnd && remap.find(payload.offset) == remap.end()) {
+                        auto &ids = m_mDedupIndex[payload.fingerprint];
+                        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+                        if (ids.empty()) {
+                            m_mDedupIndex.erase(payload.fingerprint);
+                        }
+                        payload.offset = 0;
+                        payload.size = 0;
+                    } else {
+                        payload.offset = moved(payload.offset);
+                    }
+                }
+            }
+
+            m_lOffset = out;
+            m_oFileBin.seekp(m_lOffset);
+            stats.bytesAfter = static_cast<size_t>(out);
+            stats.bytesCopied = static_cast<size_t>(out);
+        } catch (...) {
+            if (src >= 0) {close(src);}
+            if (dst >= 0) {close(dst);}
+            std::remove(tmpPath.c_str());
+            throw;
+        }
+        SaveBookkeepingData();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        debugPrint("Compacted ", stats.bytesBefore, " bytes into ", stats.bytesAfter, " bytes");
+        return stats;
+    }
+
+    /**
+     * Runs `Compact()` on a background thread.
+     */
+    std::future<CompactionStats> CompactAsync() {
+        return std::async(std::launch::async, [this]() {
+            return Compact();
+        });
+    }
+
     void Nuke() {
         try {
             std::lock_guard<std::mutex> lock(m_oMutexOffsets);
@@ -191,19 +994,34 @@ public:
             }
 
             m_mOffsets.clear();
+            m_mTombstones.clear();
+            m_vDeadOffsets.clear();
             m_oFileJson.clear();
         } catch (const std::exception &e) {
             throw FileError("Failed to nuke instance: " + std::string(e.what()));
         }
     }
 
+    /**
+     * @return The number of bytes written to the binary file so far.
+     */
+    size_t GetFileSize() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        return static_cast<size_t>(m_lOffset);
+    }
+
+    DedupStats GetDedupStats() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        return m_oDedupStats;
+    }
+
     size_t PeekRetId() {
         try {
-            std::lock_guard<std::mutex> lock(m_oMutexRetId);
-            if (m_lRetId == 0) {
+            const size_t next = m_lRetId.load();
+            if (next == 0) {
                 throw FileError("No retId has been generated yet");
             }
-            return m_lRetId - 1;
+            return next - 1;
         } catch (const std::exception &e) {
             throw FileError("Failed to peek retId: " + std::string(e.what()));
         }
@@ -211,8 +1029,7 @@ public:
 
     size_t GenerateRetId() {
         try {
-            std::lock_guard<std::mutex> lock(m_oMutexRetId);
-            return m_lRetId++;
+            return m_lRetId.fetch_add(1);
         } catch (const std::exception &e) {
             throw FileError("Failed to generate retId: " + std::string(e.what()));
         }
@@ -236,11 +1053,32 @@ protected:
 
             m_lOffset = m_oFileJson["meta"]["fileOffset"].asUInt64();
             m_lRetId = m_oFileJson["meta"]["retId"].asUInt64();
+            for (const auto &retId: m_oFileJson["tombstones"].getMemberNames()) {
+                m_mTombstones[std::stoull(retId)] = m_oFileJson["tombstones"][retId].asUInt64();
+            }
+            for (const auto &addr: m_oFileJson["deadOffsets"]) {
+                m_vDeadOffsets.push_back(static_cast<std::streamoff>(addr.asUInt64()));
+            }
+            if (m_bDedup) {
+                for (const auto &rec: m_oFileJson["dedup"]) {
+                    const DedupRecord payload{
+                        static_cast<std::streamoff>(rec[1].asUInt64()), static_cast<size_t>(rec[2].asUInt64()),
+                        rec[0].asUInt64()
+                    };
+                    if (payload.size != 0) {
+                        m_mDedupIndex[payload.fingerprint].push_back(m_vPayloads.size());
+                    }
+                    m_vPayloads.push_back(payload);
+                }
+            }
 
             m_oFileBin.open(m_sFileBin, std::ios::in | std::ios::out | std::ios::binary);
             if (!m_oFileBin.is_open()) {
                 throw FileError("Failed to open binary file");
             }
+            if (m_bDedup) {
+                LoadStubPayloads();
+            }
 
             debugPrint("Loaded files successfully");
         } catch (const Json::Exception &e) {
@@ -259,9 +1097,17 @@ protected:
     }
 
     void InitializeArchives() {
+        if (m_bSelfContained) {
+            m_oFileBin.seekp(m_lOffset);
+            return;
+        }
         try {
+            // The save archive writes its endianness byte where it is created: at the start of a new file, which is
+            // where the load archive reads it from, and at the end of the data of an existing one.
+            m_oFileBin.seekp(m_lOffset);
             m_oArchiveSave = std::make_unique<SymEngine::RCPBasicAwareOutputArchive<
                 cereal::PortableBinaryOutputArchive> >(m_oFileBin);
+            m_lOffset = m_oFileBin.tellp();
             m_oFileBin.seekg(0, std::ios::beg);
             m_oArchiveLoad = std::make_unique<SymEngine::RCPBasicAwareInputArchive<
                 cereal::PortableBinaryInputArchive> >(m_oFileBin);
@@ -276,7 +1122,11 @@ protected:
             debugPrint("Writing bookkeeping data to ", m_sFileJson);
             m_oFileJson["offsets"] = SerializeOffsets();
             m_oFileJson["meta"]["fileOffset"] = static_cast<Json::UInt64>(m_lOffset);
-            m_oFileJson["meta"]["retId"] = m_lRetId;
+            m_oFileJson["meta"]["retId"] = static_cast<Json::UInt64>(m_lRetId.load());
+            SerializeTombstones();
+            if (m_bDedup) {
+                m_oFileJson["dedup"] = SerializeDedupIndex();
+            }
 
             Json::StreamWriterBuilder builder;
             builder["commentStyle"] = "None";
@@ -320,13 +1170,26 @@ protected:
 
     void _Append(size_t retId, const Types &... data) {
         try {
+            // A Read() moves the shared position of the fstream, so the end of the data is restored first.
+            m_oFileBin.seekp(m_lOffset);
             auto p = m_oFileBin.tellp();
             if (!m_oFileBin.good()) {
                 throw FileError("Binary file is in bad state");
             }
 
+            ReviveRetId(retId);
+            if (m_bDedup) {
+                _AppendDedup(retId, data...);
+                return;
+            }
             m_mOffsets[retId].push_back(p);
-            (*m_oArchiveSave)(data...);
+            WriteFixed(m_oFileBin, data...);
+            if (m_bSelfContained) {
+                SymEngine::RCPBasicAwareOutputArchive<cereal::PortableBinaryOutputArchive> archive(m_oFileBin);
+                WriteArchived(archive, data...);
+            } else {
+                WriteArchived(*m_oArchiveSave, data...);
+            }
             m_lOffset = m_oFileBin.tellp();
 
             debugPrint("Appended to retId: ", retId, ", element count: ", m_mOffsets[retId].size());
@@ -335,6 +1198,254 @@ protected:
         }
     }
 
+    /**
+     * @return The number of live elements of a RetID that is in m_mOffsets. The caller holds m_oMutexOffsets.
+     */
+    size_t LiveCount(size_t retId) const {
+        const auto it = m_mTombstones.find(retId);
+        return it != m_mTombstones.end() ? it->second : m_mOffsets.at(retId).size();
+    }
+
+    /**
+     * Moves the dead elements of a tombstoned RetID out of m_mOffsets before it is appended to.
+     */
+    void ReviveRetId(size_t retId) {
+        const auto it = m_mTombstones.find(retId);
+        if (it == m_mTombstones.end()) {
+            return;
+        }
+        auto &addrList = m_mOffsets[retId];
+        for (size_t i = it->second; i < addrList.size(); i++) {
+            m_vDeadOffsets.push_back(static_cast<std::streamoff>(addrList[i]));
+        }
+        addrList.resize(it->second);
+        m_mTombstones.erase(it);
+    }
+
+    /**
+     * @return The start of every record in the file, live or dead. The caller holds m_oMutexOffsets.
+     */
+    std::vector<std::streamoff> SortedRecordStarts() const {
+        std::vector<std::streamoff> starts(m_vDeadOffsets.begin(), m_vDeadOffsets.end());
+        for (const auto &[id, addrList]: m_mOffsets) {
+            for (const auto &addr: addrList) {
+                starts.push_back(static_cast<std::streamoff>(addr));
+            }
+        }
+        std::sort(starts.begin(), starts.end());
+        starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+        return starts;
+    }
+
+    /**
+     * A record ends where the next record starts, or at the end of the data. The stub of an element of the dedup mode
+     * has a fixed size, and is followed by payloads that are not in `starts`.
+     */
+    std::streamoff RecordEnd(const std::vector<std::streamoff> &starts, std::streamoff first) const {
+        if (m_bDedup) {
+            return first + static_cast<std::streamoff>(STUB_BYTES);
+        }
+        const auto next = std::upper_bound(starts.begin(), starts.end(), first);
+        return next == starts.end() ? static_cast<std::streamoff>(m_lOffset) : *next;
+    }
+
+    /**
+     * @return The byte ranges of the distinct records referenced by a live element (and of their payloads in the dedup
+     * mode), in file order. The caller holds m_oMutexOffsets.
+     */
+    std::vector<std::pair<std::streamoff, std::streamoff> > LiveRecordRanges() const {
+        std::vector<std::streamoff> live;
+        for (const auto &[id, addrList]: m_mOffsets) {
+            const size_t n = LiveCount(id);
+            for (size_t i = 0; i < n; i++) {
+                live.push_back(static_cast<std::streamoff>(addrList[i]));
+            }
+        }
+        std::sort(live.begin(), live.end());
+        live.erase(std::unique(live.begin(), live.end()), live.end());
+        const auto starts = SortedRecordStarts();
+        std::vector<std::pair<std::streamoff, std::streamoff> > ranges;
+        ranges.reserve(live.size());
+        std::vector<uint64_t> payloads;
+        for (const auto first: live) {
+            ranges.emplace_back(first, RecordEnd(starts, first));
+            if (m_bDedup) {
+                payloads.push_back(m_mStubPayload.at(first));
+            }
+        }
+        if (m_bDedup) {
+            std::sort(payloads.begin(), payloads.end());
+            payloads.erase(std::unique(payloads.begin(), payloads.end()), payloads.end());
+            for (const auto id: payloads) {
+                const auto &payload = m_vPayloads[id];
+                ranges.emplace_back(payload.offset, payload.offset + static_cast<std::streamoff>(payload.size));
+            }
+            std::sort(ranges.begin(), ranges.end());
+        }
+        return ranges;
+    }
+
+    /**
+     * Appends the bytes [first, last) of `src` to `dst` at `out` through `buffer`, and advances `out`.
+     */
+    static void CopyRange(int src, int dst, std::streamoff first, std::streamoff last, std::streamoff &out,
+                          std::vector<char> &buffer) {
+        while (first < last) {
+            const auto len = static_cast<size_t>(std::min<std::streamoff>(last - first, buffer.size()));
+            const auto n = pread(src, buffer.data(), len, static_cast<off_t>(first));
+            if (n <= 0) {
+                throw FileError("Failed to read a record during compaction");
+            }
+            for (ssize_t done = 0; done < n;) {
+                const auto w = pwrite(dst, buffer.data() + done, static_cast<size_t>(n - done),
+                                      static_cast<off_t>(out + done));
+                if (w <= 0) {
+                    throw FileError("Failed to write a record during compaction");
+                }
+                done += w;
+            }
+            first += n;
+            out += n;
+        }
+    }
+
+    void SerializeTombstones() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        Json::Value tombstones(Json::objectValue);
+        for (const auto &[retId, n]: m_mTombstones) {
+            tombstones[std::to_string(retId)] = static_cast<Json::UInt64>(n);
+        }
+        Json::Value dead(Json::arrayValue);
+        for (const auto o: m_vDeadOffsets) {
+            dead.append(static_cast<Json::UInt64>(o));
+        }
+        m_oFileJson["tombstones"] = tombstones;
+        m_oFileJson["deadOffsets"] = dead;
+    }
+
+    /**
+     * The 64-bit FNV-1a hash of `bytes`. The fingerprints are persisted in the json file, so they must not depend on
+     * the standard library the way `std::hash` does.
+     */
+    static uint64_t Fingerprint(const std::string &bytes) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const unsigned char c: bytes) {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /**
+     * @return Whether the record at `offset` holds exactly `bytes`.
+     */
+    bool RecordEquals(std::streamoff offset, const std::string &bytes) {
+        std::string stored(bytes.size(), '\0');
+        m_oFileBin.seekg(offset);
+        m_oFileBin.read(&stored[0], static_cast<std::streamsize>(stored.size()));
+        if (!m_oFileBin.good()) {
+            m_oFileBin.clear();
+            return false;
+        }
+        return stored == bytes;
+    }
+
+    /**
+     * @return The payload of the stub at `stub`. The caller holds m_oMutexOffsets.
+     */
+    const DedupRecord &PayloadOf(std::streamoff stub) const {
+        return m_vPayloads.at(m_mStubPayload.at(stub));
+    }
+
+    /**
+     * Reads the payload ids of the stubs of a loaded file.
+     */
+    void LoadStubPayloads() {
+        auto load = [&](std::streamoff stub) {
+            uint64_t id;
+            m_oFileBin.seekg(stub + static_cast<std::streamoff>(FIXED_BYTES));
+            m_oFileBin.read(reinterpret_cast<char *>(&id), sizeof(id));
+            if (!m_oFileBin.good() || id >= m_vPayloads.size()) {
+                throw FileError("Failed to read the payload id of the stub at " + std::to_string(stub));
+            }
+            m_mStubPayload[stub] = id;
+        };
+        for (const auto &[retId, addrList]: m_mOffsets) {
+            for (const auto &addr: addrList) {
+                load(static_cast<std::streamoff>(addr));
+            }
+        }
+        for (const auto o: m_vDeadOffsets) {
+            load(o);
+        }
+    }
+
+    void _AppendDedup(size_t retId, const Types &... data) {
+        std::ostringstream oss;
+        {
+            SymEngine::RCPBasicAwareOutputArchive<cereal::PortableBinaryOutputArchive> archive(oss);
+            WriteArchived(archive, data...);
+        }
+        const std::string bytes = oss.str();
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t fp = Fingerprint(bytes);
+        auto &ids = m_mDedupIndex[fp];
+        const auto hit = std::find_if(ids.begin(), ids.end(), [&](uint64_t id) {
+            const auto &payload = m_vPayloads[id];
+            return payload.size == bytes.size() && RecordEquals(payload.offset, bytes);
+        });
+        m_oDedupStats.hashSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        m_oDedupStats.appends++;
+
+        const bool isHit = hit != ids.end();
+        uint64_t id;
+        if (isHit) {
+            id = *hit;
+            m_oDedupStats.hits++;
+            m_oDedupStats.bytesSaved += bytes.size();
+        } else {
+            m_oFileBin.seekp(m_lOffset);
+            m_oFileBin.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!m_oFileBin.good()) {
+                throw FileError("Failed to write to the binary file");
+            }
+            id = m_vPayloads.size();
+            m_vPayloads.push_back({static_cast<std::streamoff>(m_lOffset), bytes.size(), fp});
+            ids.push_back(id);
+            m_lOffset = m_oFileBin.tellp();
+            m_oDedupStats.bytesWritten += bytes.size();
+        }
+
+        // RecordEquals() moved the shared position of the fstream.
+        m_oFileBin.seekp(m_lOffset);
+        WriteFixed(m_oFileBin, data...);
+        m_oFileBin.write(reinterpret_cast<const char *>(&id), sizeof(id));
+        if (!m_oFileBin.good()) {
+            throw FileError("Failed to write to the binary file");
+        }
+        m_mStubPayload[static_cast<std::streamoff>(m_lOffset)] = id;
+        m_mOffsets[retId].push_back(m_lOffset);
+        m_lOffset = m_oFileBin.tellp();
+        m_oDedupStats.bytesWritten += STUB_BYTES;
+        debugPrint(isHit ? "Deduplicated an element of retId: " : "Appended to retId: ", retId,
+                   ", element count: ", m_mOffsets[retId].size());
+    }
+
+    Json::Value SerializeDedupIndex() {
+        std::lock_guard<std::mutex> lock(m_oMutexOffsets);
+        // [fingerprint, offset, size] of every payload, by id.
+        Json::Value root(Json::arrayValue);
+        for (const auto &payload: m_vPayloads) {
+            Json::Value rec;
+            rec.append(static_cast<Json::UInt64>(payload.fingerprint));
+            rec.append(static_cast<Json::UInt64>(payload.offset));
+            rec.append(static_cast<Json::UInt64>(payload.size));
+            root.append(rec);
+        }
+        return root;
+    }
+
     Json::Value SerializeOffsets() {
         try {
             std::lock_guard<std::mutex> lock(m_oMutexOffsets);
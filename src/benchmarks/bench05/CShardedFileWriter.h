@@ -0,0 +1,259 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CFileWriterBase.h"
+
+/**
+ * How CShardedFileWriter picks the segment of an appended element.
+ */
+enum class ShardBy {
+    RETID,
+    THREAD
+};
+
+/**
+ * A CFileWriterBase split into `shards` segments (`<name>.s<k>.bin/json`), each one with its own file, archives and
+ * lock, so that parallel producers do not serialize on a single file:
+ *  - `ShardBy::RETID`: the elements of RetID `r` go to segment `r % shards`. Every RetID lives in a single segment, so
+ *    (retId, idx) maps to (r % shards, idx) without any extra bookkeeping. The producers only run in parallel when
+ *    they append to RetIDs of different segments.
+ *  - `ShardBy::THREAD`: every producer thread is assigned a segment (round robin) on its first append, and appends
+ *    there whatever the RetID. A global index maps (retId, idx) to (segment, index within the segment), behind
+ *    `INDEX_STRIPES` striped locks that are only held to push or look up an entry, never while serializing.
+ * `GenerateRetId()` is a lock-free atomic and the reads are transparent: `Read(retId, idx)` finds the segment and reads
+ * through it. With more threads than segments, the threads sharing a segment take turns on its lock.
+ *
+ * The exprs of different threads share nodes (at least the symbols), so appending from several threads requires
+ * SymEngine to be built with `WITH_SYMENGINE_THREAD_SAFE=ON`.
+ *
+ * Usage:
+ *  CShardedFileWriter<size_t, RCP<const Basic>> writer(dir, "name", 8, ShardBy::THREAD);
+ *  // On every producer thread:
+ *  const auto retId = writer.GenerateRetId();
+ *  writer.Append(retId, {i, expr});
+ */
+template<typename... Types>
+class CShardedFileWriter {
+public:
+    using segment_t = CFileWriterBase<Types...>;
+
+private:
+    static constexpr size_t INDEX_STRIPES = 64;
+    static inline std::atomic<uint64_t> s_lNextInstanceId{1};
+
+    struct IndexStripe {
+        std::mutex mutex;
+        // retId -> (segment, index within the segment) of every element.
+        std::unordered_map<size_t, std::vector<std::pair<uint32_t, size_t> > > entries;
+    };
+
+    const std::string m_sName, m_sBasePath, m_sFileJson;
+    const ShardBy m_eShardBy;
+    // Keys the segments of the producer threads, see ThreadSegment().
+    const uint64_t m_lInstanceId = s_lNextInstanceId++;
+    std::vector<std::unique_ptr<segment_t> > m_vSegments;
+    std::vector<IndexStripe> m_vIndex;
+    std::atomic<size_t> m_lRetId{0};
+    std::atomic<size_t> m_lNextSegment{0};
+    bool m_bNuked = false;
+
+    IndexStripe &Stripe(size_t retId) {
+        return m_vIndex[retId % INDEX_STRIPES];
+    }
+
+    size_t ThreadSegment() {
+        // Instance ids are never reused, so a writer allocated where a destroyed one was never gets its stale segment,
+        // and a thread that alternates between writers keeps its segment in each of them.
+        thread_local uint64_t t_lLastId = 0;
+        thread_local size_t t_lLastSegment = 0;
+        if (t_lLastId != m_lInstanceId) {
+            thread_local std::unordered_map<uint64_t, size_t> t_mSegments;
+            auto it = t_mSegments.find(m_lInstanceId);
+            if (it == t_mSegments.end()) {
+                it = t_mSegments.emplace(m_lInstanceId, m_lNextSegment.fetch_add(1)).first;
+            }
+            t_lLastId = m_lInstanceId;
+            t_lLastSegment = it->second;
+        }
+        return t_lLastSegment % m_vSegments.size();
+    }
+
+    void LoadIndex() {
+        std::ifstream jsonFile(m_sFileJson);
+        if (!jsonFile.good()) {
+            return;
+        }
+        Json::Value root;
+        jsonFile >> root;
+        if (root["meta"]["shards"].asUInt64() != m_vSegments.size() ||
+            root["meta"]["shardBy"].asString() != ShardByName()) {
+            throw std::runtime_error("Sharded writer configuration mismatch for " + m_sName);
+        }
+        m_lRetId = root["meta"]["retId"].asUInt64();
+        const auto &index = root["index"];
+        for (const auto &retId: index.getMemberNames()) {
+            const size_t retIdInt = std::stoull(retId);
+            auto &entries = Stripe(retIdInt).entries[retIdInt];
+            for (const auto &e: index[retId]) {
+                entries.emplace_back(e[0].asUInt(), e[1].asUInt64());
+            }
+        }
+    }
+
+    void SaveIndex() {
+        Json::Value root;
+        root["meta"]["name"] = m_sName;
+        root["meta"]["shards"] = static_cast<Json::UInt64>(m_vSegments.size());
+        root["meta"]["shardBy"] = ShardByName();
+        root["meta"]["retId"] = static_cast<Json::UInt64>(m_lRetId.load());
+        for (auto &stripe: m_vIndex) {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            for (const auto &[retId, entries]: stripe.entries) {
+                Json::Value list(Json::arrayValue);
+                for (const auto &[segment, local]: entries) {
+                    Json::Value e;
+                    e.append(segment);
+                    e.append(static_cast<Json::UInt64>(local));
+                    list.append(e);
+                }
+                root["index"][std::to_string(retId)] = list;
+            }
+        }
+        Json::StreamWriterBuilder builder;
+        builder["commentStyle"] = "None";
+        builder["indentation"] = "    ";
+        std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+        std::ofstream outputFileStream(m_sFileJson);
+        if (!outputFileStream.is_open()) {
+            throw std::runtime_error("Failed to open JSON file for writing");
+        }
+        writer->write(root, &outputFileStream);
+    }
+
+    const char *ShardByName() const {
+        return m_eShardBy == ShardBy::RETID ? "retId" : "thread";
+    }
+
+public:
+    CShardedFileWriter(
+        const std::string &basePath,
+        const std::string &name,
+        size_t shards,
+        ShardBy shardBy = ShardBy::RETID,
+        bool load_if_exists = false,
+        bool selfContained = false
+    ) : m_sName(name), m_sBasePath(basePath), m_sFileJson(basePath + name + ".json"), m_eShardBy(shardBy),
+        m_vIndex(INDEX_STRIPES) {
+        if (shards == 0) {
+            throw std::runtime_error("A sharded writer needs at least one segment");
+        }
+        for (size_t k = 0; k < shards; k++) {
+            m_vSegments.push_back(std::make_unique<segment_t>(
+                basePath, name + ".s" + std::to_string(k), load_if_exists, false, selfContained));
+        }
+        if (load_if_exists) {
+            LoadIndex();
+        }
+    }
+
+    ~CShardedFileWriter() {
+        try {
+            if (!m_bNuked) {
+                SaveIndex();
+            }
+        } catch (const std::exception &e) {
+            std::cout << "CShardedFileWriter: Error in destructor: " << e.what() << std::endl;
+        }
+    }
+
+    size_t GenerateRetId() {
+        return m_lRetId.fetch_add(1);
+    }
+
+    /**
+     * @return The index of the element within the RetID.
+     */
+    size_t Append(size_t retId, const std::tuple<Types...> &data) {
+        if (m_eShardBy == ShardBy::RETID) {
+            return m_vSegments[retId % m_vSegments.size()]->Append(retId, data);
+        }
+        const size_t segment = ThreadSegment();
+        const size_t local = m_vSegments[segment]->Append(retId, data);
+        auto &stripe = Stripe(retId);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto &entries = stripe.entries[retId];
+        entries.emplace_back(static_cast<uint32_t>(segment), local);
+        return entries.size() - 1;
+    }
+
+    std::tuple<Types...> Read(size_t retId, size_t stateIndex) {
+        if (m_eShardBy == ShardBy::RETID) {
+            return m_vSegments[retId % m_vSegments.size()]->Read(retId, stateIndex);
+        }
+        std::pair<uint32_t, size_t> entry;
+        {
+            auto &stripe = Stripe(retId);
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            auto it = stripe.entries.find(retId);
+            if (it == stripe.entries.end() || stateIndex >= it->second.size()) {
+                throw std::runtime_error("Invalid retId or state index: " + std::to_string(retId) + ", " +
+                                         std::to_string(stateIndex));
+            }
+            entry = it->second[stateIndex];
+        }
+        return m_vSegments[entry.first]->Read(retId, entry.second);
+    }
+
+    size_t GetElementCount(size_t retId) {
+        if (m_eShardBy == ShardBy::RETID) {
+            return m_vSegments[retId % m_vSegments.size()]->GetElementCount(retId);
+        }
+        auto &stripe = Stripe(retId);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.entries.find(retId);
+        return it == stripe.entries.end() ? 0 : it->second.size();
+    }
+
+    size_t GetShardCount() const {
+        return m_vSegments.size();
+    }
+
+    segment_t &GetSegment(size_t k) {
+        return *m_vSegments.at(k);
+    }
+
+    /**
+     * @return The number of bytes written to all the segments so far.
+     */
+    size_t GetFileSize() {
+        size_t size = 0;
+        for (auto &segment: m_vSegments) {
+            size += segment->GetFileSize();
+        }
+        return size;
+    }
+
+    void Nuke() {
+        m_bNuked = true;
+        for (auto &segment: m_vSegments) {
+            segment->Nuke();
+        }
+        for (auto &stripe: m_vIndex) {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.entries.clear();
+        }
+        if (boost::filesystem::exists(m_sFileJson)) {
+            boost::filesystem::remove(m_sFileJson);
+        }
+    }
+};
@@ -0,0 +1,269 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <malloc.h>
+
+#include "CFileWriterBase.h"
+#include "utils/mem_usage_tracker.h"
+
+/**
+ * Pages the least recently used exprs out to a CFileWriterBase file under memory pressure, and back in on access.
+ * Every expr is held behind a `Handle`; `Handle::Get()` returns the expr, reloading it first if it was spilled, and
+ * marks it as the most recently used. `Attach()` hooks `OnPressure()` to the soft limit of a mem_usage_tracker; the
+ * coldest exprs are then spilled, in batches of an eighth of the resident ones, until the RSS is back under the limit
+ * (or nothing is left to spill). When the tracker hits its hard limit, every resident expr is spilled before the
+ * tracker gives up and exits.
+ *
+ * Spilling copies and releases the RCPs of the exprs, and their nodes (at least the symbols) are shared with the exprs
+ * that the owning thread keeps building. Unless SymEngine is built with `WITH_SYMENGINE_THREAD_SAFE=ON`, the sampler
+ * thread therefore only flags the pressure, and the spills run on the owning thread, in `Poll()`, which `Track()` and
+ * `Handle::Get()` call first. A workload that stops calling them for a while should call `Poll()` itself.
+ *
+ * An expr is written to the file the first time it is spilled only: the exprs are immutable, so a reloaded expr that is
+ * spilled again just drops its pointer. Spilling an expr only frees memory if the handle holds its last reference; the
+ * nodes it shares with the resident exprs (at least the symbols) stay in memory, and come back as distinct copies when
+ * it is reloaded.
+ *
+ * A handle stops tracking its expr when its last copy is destroyed; the handles must not outlive the manager.
+ *
+ * The counters are kept per phase: `ReportPhase()` prints the spills and reloads since the previous call and resets
+ * them.
+ *
+ * Usage:
+ *  CSpillManager spill(dir, "name");
+ *  spill.Attach(mem_tracker, softLimitGigs);
+ *  auto h = spill.Track(expr);
+ *  use(h.Get());
+ *  spill.ReportPhase("phase");
+ */
+class CSpillManager {
+public:
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+    using storage_t = CFileWriterBase<rcp_basic>;
+
+    struct SpillStats {
+        size_t spills = 0;
+        // The spills that had to serialize the expr (the others were written by a previous spill).
+        size_t spillWrites = 0;
+        size_t reloads = 0;
+        size_t pressureEvents = 0;
+    };
+
+private:
+    struct Entry;
+    using lru_t = std::list<Entry *>;
+
+    struct Entry {
+        rcp_basic expr;
+        // The index of the record of the expr within the RetID of the manager, once it was written.
+        long index = -1;
+        bool resident = true;
+        lru_t::iterator lru;
+    };
+
+    storage_t m_oStorage;
+    const size_t m_lRetId;
+    std::mutex m_oMutex;
+    // The resident entries, the most recently used first.
+    lru_t m_lLru;
+    SpillStats m_oPhaseStats, m_oTotalStats;
+    mem_usage_tracker *m_pTracker = nullptr;
+    double m_dSoftLimit = 0;
+    // The pressure flagged by the sampler thread, for Poll().
+    std::atomic<bool> m_bPressure{false};
+    std::atomic<bool> m_bPressureHard{false};
+    std::atomic<double> m_dPressureRss{0};
+
+    void Count(size_t SpillStats::*field) {
+        m_oPhaseStats.*field += 1;
+        m_oTotalStats.*field += 1;
+    }
+
+    void Touch(Entry &e) {
+        m_lLru.splice(m_lLru.begin(), m_lLru, e.lru);
+    }
+
+    /**
+     * Spills up to `count` entries from the cold end of the LRU list. The caller holds m_oMutex.
+     */
+    size_t SpillColdest(size_t count) {
+        size_t spilled = 0;
+        while (spilled < count && !m_lLru.empty()) {
+            Entry &e = *m_lLru.back();
+            if (e.index < 0) {
+                e.index = static_cast<long>(m_oStorage.Append(m_lRetId, {e.expr}));
+                Count(&SpillStats::spillWrites);
+            }
+            e.expr = rcp_basic();
+            e.resident = false;
+            m_lLru.pop_back();
+            Count(&SpillStats::spills);
+            spilled++;
+        }
+        return spilled;
+    }
+
+public:
+    class Handle {
+        friend class CSpillManager;
+
+    private:
+        CSpillManager *m_pOwner = nullptr;
+        std::shared_ptr<Entry> m_pEntry;
+
+        Handle(CSpillManager *owner, std::shared_ptr<Entry> entry) : m_pOwner(owner), m_pEntry(std::move(entry)) {}
+
+    public:
+        Handle() = default;
+
+        rcp_basic Get() const {
+            m_pOwner->Poll();
+            return m_pOwner->Load(*m_pEntry);
+        }
+
+        bool IsResident() const {
+            std::lock_guard<std::mutex> lock(m_pOwner->m_oMutex);
+            return m_pEntry->resident;
+        }
+    };
+
+    CSpillManager(const std::string &basePath, const std::string &name) :
+        m_oStorage(basePath, name, false, false, true),
+        m_lRetId(m_oStorage.GenerateRetId()) {
+    }
+
+    ~CSpillManager() {
+        Detach();
+        m_oStorage.Nuke();
+    }
+
+    CSpillManager(const CSpillManager &) = delete;
+
+    CSpillManager &operator=(const CSpillManager &) = delete;
+
+    /**
+     * Spills under the soft limit `softLimitGigs` on the RSS, sampled by `tracker`. The manager must outlive the
+     * tracker or be detached first (the destructor detaches it).
+     */
+    void Attach(mem_usage_tracker &tracker, double softLimitGigs) {
+        Detach();
+        m_pTracker = &tracker;
+        m_dSoftLimit = softLimitGigs;
+        tracker.setSoftLimit(softLimitGigs, [this](double rssGigs, bool hardLimit) { OnPressure(rssGigs, hardLimit); });
+    }
+
+    void Detach() {
+        if (m_pTracker != nullptr) {
+            m_pTracker->clearSoftLimit();
+            m_pTracker = nullptr;
+        }
+    }
+
+    Handle Track(rcp_basic expr) {
+        Poll();
+        // The last copy of the handle unlinks the entry. The record of a spilled expr stays in the file until the
+        // manager is destroyed.
+        std::shared_ptr<Entry> entry(new Entry(), [this](Entry *e) {
+            {
+                std::lock_guard<std::mutex> lock(m_oMutex);
+                if (e->resident) {
+                    m_lLru.erase(e->lru);
+                }
+            }
+            delete e;
+        });
+        entry->expr = std::move(expr);
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        m_lLru.push_front(entry.get());
+        entry->lru = m_lLru.begin();
+        return {this, entry};
+    }
+
+    /**
+     * Called from the sampler thread of the attached tracker. Spills right away if SymEngine is thread-safe, otherwise
+     * flags the pressure for the next `Poll()`.
+     */
+    void OnPressure(double rssGigs, bool hardLimit) {
+#ifdef WITH_SYMENGINE_THREAD_SAFE
+        Spill(rssGigs, hardLimit);
+#else
+        m_dPressureRss.store(rssGigs);
+        if (hardLimit) {
+            m_bPressureHard.store(true);
+        }
+        m_bPressure.store(true);
+#endif
+    }
+
+    /**
+     * Runs the spills flagged by the sampler thread since the last call, if any. Must be called from the thread that
+     * owns the exprs; it costs an atomic exchange when there is no pressure.
+     */
+    void Poll() {
+        if (m_bPressure.exchange(false)) {
+            Spill(m_dPressureRss.load(), m_bPressureHard.exchange(false));
+        }
+    }
+
+    /**
+     * Spills the coldest exprs until the RSS is under the soft limit, or all of them on the hard limit.
+     */
+    void Spill(double rssGigs, bool hardLimit = false) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        Count(&SpillStats::pressureEvents);
+        while ((hardLimit || rssGigs > m_dSoftLimit) && !m_lLru.empty()) {
+            SpillColdest(hardLimit ? m_lLru.size() : std::max<size_t>(1, m_lLru.size() / 8));
+            // Hands the freed heap back to the kernel, otherwise the RSS does not move.
+            malloc_trim(0);
+            rssGigs = mem_usage_tracker::getResidentUsage();
+        }
+    }
+
+private:
+    rcp_basic Load(Entry &e) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (!e.resident) {
+            e.expr = std::get<0>(m_oStorage.Read(m_lRetId, static_cast<size_t>(e.index)));
+            e.resident = true;
+            m_lLru.push_front(&e);
+            e.lru = m_lLru.begin();
+            Count(&SpillStats::reloads);
+        } else {
+            Touch(e);
+        }
+        return e.expr;
+    }
+
+public:
+    size_t GetResidentCount() {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        return m_lLru.size();
+    }
+
+    size_t GetFileSize() {
+        return m_oStorage.GetFileSize();
+    }
+
+    SpillStats GetTotalStats() {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        return m_oTotalStats;
+    }
+
+    SpillStats ReportPhase(const std::string &phase) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        const SpillStats stats = m_oPhaseStats;
+        m_oPhaseStats = SpillStats();
+        std::cout << "Spill manager, phase " << phase << ": " << stats.spills << " spills (" << stats.spillWrites <<
+            " written), " << stats.reloads << " reloads, " << stats.pressureEvents << " pressure events, " <<
+            m_lLru.size() << " exprs resident" << std::endl;
+        return stats;
+    }
+};
@@ -10,6 +10,8 @@
 #include "symengine/basic.h"
 #include "symengine/mul.h"
 #include "symengine/pow.h"
+#include "utils/visitor_sym.h"
+#include "utils/expr_builder.h"
 
 
 void bench05::Preparation() {
@@ -33,9 +35,9 @@ void bench05::Preparation() {
 void bench05::Workload() {
     std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
     {
-        mem_usage_tracker mem_expr_gen(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".expr_gen.txt", true);
+        auto phase = Phase("expr_gen");
+        add_builder builder(cfg_L);
         for (size_t i = 0; i < cfg_N; i++) {
-            SymEngine::RCP<const SymEngine::Basic> expr = SymEngine::zero;
             for (size_t j = 0; j < cfg_L; j++) {
                 auto base = SymEngine::add(
                     SymEngine::add(
@@ -44,17 +46,26 @@ void bench05::Workload() {
                     ),
                     id_to_sym[get_symbol_id(2, j)]
                 );
-                expr = SymEngine::add(expr, SymEngine::pow(base, SymEngine::integer(get_random_integer(1, cfg_P))));
+                builder.add_term(SymEngine::pow(base, SymEngine::integer(get_random_integer(1, cfg_P))));
             }
+            auto expr = builder.build();
             //exprs.push_back(SymEngine::expand(expr));
             exprs.push_back(expr);
         }
     }
 
-    CFileWriterBase<size_t, SymEngine::RCP<const SymEngine::Basic>> writer("/tmp/", "bench05", true, true);
-    auto read_verify = [&](size_t __retid, size_t index, SymEngine::RCP<const SymEngine::Basic> gold) {
+    CFileWriterBase<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench05", true, true);
+    // `stats`, if any, times the read alone, without the verification.
+    auto read_verify = [&](size_t __retid, size_t index, SymEngine::RCP<const SymEngine::Basic> gold,
+                           timer_stats *stats = nullptr) {
         SymEngine::RCP<const SymEngine::Basic> uut;
-        auto tuple = writer.Read(__retid, index);
+        std::tuple<size_t, SymEngine::RCP<const SymEngine::Basic>> tuple;
+        if (stats) {
+            timer_scope ts(*stats);
+            tuple = writer.Read(__retid, index);
+        } else {
+            tuple = writer.Read(__retid, index);
+        }
         size_t uut_index = std::get<0>(tuple);
         uut = std::get<1>(tuple);
         if (uut_index != index) {
@@ -72,7 +83,9 @@ void bench05::Workload() {
             throw std::runtime_error("Serialization mismatch");
         }
     };
+    std::cout << "Interleaved append/read on a single RetID." << std::endl;
     {
+        auto phase = Phase("interleaved");
         const auto retid = writer.GenerateRetId();
         for (size_t i = 0; i < 2; i++) {
             writer.Append(retid, {i, exprs[i]});
@@ -86,12 +99,50 @@ void bench05::Workload() {
         read_verify(retid, 2, exprs[2]);
     }
 
+    // Outside of any phase, so it does not pollute the counters of the phases.
+    const size_t node_count = count_unique_nodes(exprs);
+    std::cout << "Number of unique nodes in the exprs: " << node_count << std::endl;
+
     const auto new_retid = writer.GenerateRetId();
-    for (size_t i = 0; i < cfg_N; i++) {
-        writer.Append(new_retid, {i, exprs[i]});
+    std::cout << "Saving the exprs onto the disk." << std::endl;
+    {
+        auto phase = Phase("expr_save");
+        phase.SetUnits(node_count);
+        for (size_t i = 0; i < cfg_N; i++) {
+            writer.Append(new_retid, {i, exprs[i]});
+        }
+    }
+    // One sample per element: a full Read() against a ReadField() of the header only.
+    const std::map<std::string, int> params = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    timer_stats stats_read("bench05 read", params);
+    timer_stats stats_meta_scan("bench05 meta_scan", params);
+    std::cout << "Loading and verifying the exprs from the disk." << std::endl;
+    {
+        auto phase = Phase("expr_load");
+        phase.SetUnits(node_count);
+        for (size_t i = 0; i < cfg_N; i++) {
+            read_verify(new_retid, i, exprs[i], &stats_read);
+        }
     }
-    for (size_t i = 0; i < cfg_N; i++) {
-        read_verify(new_retid, i, exprs[i]);
+    std::cout << "Scanning the indices of the exprs (header fields only)." << std::endl;
+    {
+        auto phase = Phase("meta_scan");
+        for (size_t i = 0; i < cfg_N; i++) {
+            size_t index;
+            {
+                timer_scope ts(stats_meta_scan);
+                index = writer.ReadField<0>(new_retid, i);
+            }
+            if (index != i) {
+                std::cout << "Mismatch in the header of the element " << i << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
     }
+    // The samples are still in the shards of the recording thread.
+    stats_read.flush_threads();
+    stats_meta_scan.flush_threads();
+    std::cout << "Mean per element: read " << stats_read.ave() << " ms, header only " << stats_meta_scan.ave() <<
+        " ms" << std::endl;
 
 }
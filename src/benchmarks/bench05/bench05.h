@@ -13,11 +13,12 @@ class bench05: public benchmark_base {
 protected:
     std::unordered_map<size_t, SymEngine::RCP<const SymEngine::Basic>> id_to_sym;
     const size_t cfg_N, cfg_L, cfg_P;
+    const std::string storage_dir;
     SymEngine::vec_basic exprs;
 public:
-    bench05(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+    bench05(size_t cfg_N, size_t cfg_L, size_t cfg_P, const std::string& storage_dir = "/tmp/") :
         benchmark_base("bench05"),
-        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P)
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), storage_dir(storage_dir)
     {}
 
     void Preparation() override;
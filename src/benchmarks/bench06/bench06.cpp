@@ -0,0 +1,93 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <memory>
+
+#include "bench06.h"
+#include "sum_of_powers.h"
+#include "symengine/constants.h"
+#include "symengine/add.h"
+#include "utils/expr_builder.h"
+
+
+void bench06::Preparation() {
+}
+
+/**
+ * This benchmark compares three ways of summing the L terms of
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * for L = 1024, 2048, ..., cfg_L:
+ *  - repeated: expr = SymEngine::add(expr, term), as bench01 and bench05 used to do.
+ *  - vec_basic: SymEngine::add(terms).
+ *  - builder: add_builder, canonicalizing once through Add::from_dict.
+ * The terms are generated beforehand so only the summation is timed, and the three results are checked to be equal.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs per L.
+ *  - L: Largest number of terms in each expr.
+ *  - P: Power of each term.
+ */
+void bench06::Workload() {
+    for (size_t L = 1024; L <= cfg_L; L *= 2) {
+        std::cout << "Summing " << cfg_N << " expressions of length " << L << " and power " << cfg_P << std::endl;
+        const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)L}, {"P", (int)cfg_P}};
+        const std::string suffix = "_L" + std::to_string(L);
+
+        sum_of_powers gen(L, cfg_P);
+        std::vector<SymEngine::vec_basic> terms;
+        {
+            auto phase = Phase("terms" + suffix);
+            gen.make_symbols();
+            for (size_t i = 0; i < cfg_N; i++) {
+                terms.push_back(gen.terms());
+            }
+        }
+
+        SymEngine::vec_basic res_repeated, res_vec, res_builder;
+        if (L <= cfg_L_repeated_max) {
+            auto phase = Phase("repeated" + suffix);
+            timer_stats stats("bench06 repeated add", pairs);
+            for (size_t i = 0; i < cfg_N; i++) {
+                timer_scope ts(stats);
+                SymEngine::RCP<const SymEngine::Basic> expr = SymEngine::zero;
+                for (auto &t : terms[i]) {
+                    expr = SymEngine::add(expr, t);
+                }
+                res_repeated.push_back(expr);
+            }
+        } else {
+            std::cout << "Skipping the repeated add for L=" << L << " (quadratic)" << std::endl;
+        }
+
+        {
+            auto phase = Phase("vec_basic" + suffix);
+            timer_stats stats("bench06 add vec_basic", pairs);
+            for (size_t i = 0; i < cfg_N; i++) {
+                timer_scope ts(stats);
+                res_vec.push_back(SymEngine::add(terms[i]));
+            }
+        }
+
+        {
+            auto phase = Phase("builder" + suffix);
+            timer_stats stats("bench06 add_builder", pairs);
+            add_builder builder(L);
+            for (size_t i = 0; i < cfg_N; i++) {
+                timer_scope ts(stats);
+                for (auto &t : terms[i]) {
+                    builder.add_term(t);
+                }
+                res_builder.push_back(builder.build());
+            }
+        }
+
+        for (size_t i = 0; i < cfg_N; i++) {
+            if (not SymEngine::eq(*res_vec[i], *res_builder[i]) ||
+                (!res_repeated.empty() && not SymEngine::eq(*res_repeated[i], *res_builder[i]))) {
+                std::cout << "Mismatch between the summation methods at expr " << i << " for L=" << L << std::endl;
+                throw std::runtime_error("Summation mismatch");
+            }
+        }
+    }
+}
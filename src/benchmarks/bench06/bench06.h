@@ -0,0 +1,26 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "symengine/basic.h"
+
+class bench06: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    const size_t cfg_L_repeated_max;
+public:
+    /**
+     * @param cfg_L_repeated_max The repeated add(expr, term) path is quadratic in L, so it is skipped above this length.
+     */
+    bench06(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_L_repeated_max = 1024 * 16) :
+        benchmark_base("bench06"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_L_repeated_max(cfg_L_repeated_max)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
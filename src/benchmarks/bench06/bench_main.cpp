@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench06/bench06.h"
+
+int main() {
+    bench06 b(4, 1024*64, 5);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
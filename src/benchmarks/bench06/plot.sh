@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench06 --file mem_usage_bench06.txt | tee /dev/tty
@@ -0,0 +1,103 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench07.h"
+#include "sum_of_powers.h"
+#include "utils/hash_cons.h"
+#include "utils/expr_builder.h"
+#include "utils/visitor_sym.h"
+
+
+void bench07::Preparation() {
+}
+
+SymEngine::vec_basic bench07::Generate(size_t n, timer_stats &stats) {
+    SymEngine::vec_basic syms;
+    for (size_t j = 0; j < cfg_L; j++) {
+        syms.push_back(hc::symbol("a_" + std::to_string(j)));
+        syms.push_back(hc::symbol("b_" + std::to_string(j)));
+        syms.push_back(hc::symbol("c_" + std::to_string(j)));
+    }
+
+    SymEngine::vec_basic exprs;
+    add_builder builder(cfg_L);
+    for (size_t i = 0; i < n; i++) {
+        timer_scope ts(stats);
+        for (size_t j = 0; j < cfg_L; j++) {
+            auto base = hc::add(hc::add(syms[3 * j], syms[3 * j + 1]), syms[3 * j + 2]);
+            auto exp = hc::integer(static_cast<long>(sum_of_powers::get_random_integer(1, cfg_P)));
+            builder.add_term(hc::pow(base, exp));
+        }
+        exprs.push_back(hc::intern(builder.build()));
+    }
+    return exprs;
+}
+
+/**
+ * This benchmark measures the trade-off of the hash_cons unique table on the bench01 workload:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * For N = 16, 32, ..., cfg_N, the exprs are built once with plain SymEngine and once through the unique table, and
+ * the construction time and the heap growth of both are reported. The same random exponents are used for both modes.
+ *
+ *  So our parameters are:
+ *  - N: Largest number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ */
+void bench07::Workload() {
+    auto &table = hash_cons::instance();
+    for (size_t N = 16; N <= cfg_N; N *= 2) {
+        std::cout << "Generating " << N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+        const std::map<std::string, int> pairs = {{"N", (int)N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+        const unsigned seed = static_cast<unsigned>(N);
+        std::vector<SymEngine::hash_t> plain_hashes;
+
+        for (bool consed : {false, true}) {
+            const std::string mode = consed ? "hash_cons" : "plain";
+            if (consed) {
+                table.enable();
+            } else {
+                table.disable();
+            }
+            srand(seed);
+
+            const auto before = phase_profiler::read_memory_counters();
+            SymEngine::vec_basic exprs;
+            {
+                auto phase = Phase(mode + "_N" + std::to_string(N));
+                timer_stats stats("bench07 " + mode, pairs);
+                exprs = Generate(N, stats);
+            }
+            const auto after = phase_profiler::read_memory_counters();
+
+            std::cout << "Mode " << mode << ": heap growth " <<
+                (static_cast<double>(after.heap_in_use_bytes) - before.heap_in_use_bytes) / 1048576.0 <<
+                " MB, RSS growth " << (static_cast<double>(after.rss_bytes) - before.rss_bytes) / 1048576.0 <<
+                " MB, unique nodes " << count_unique_nodes(exprs) << std::endl;
+            if (consed) {
+                auto st = table.get_stats();
+                std::cout << "Unique table: " << st.nodes << " nodes, " << st.ops << " ops, " << st.symbols <<
+                    " symbols, " << st.integers << " integers, " << st.hits << " hits, " << st.misses << " misses" <<
+                    std::endl;
+            }
+            // Both modes must produce the same exprs; compare their hashes, keeping the plain ones alive would skew
+            // the memory of the hash_cons mode.
+            std::vector<SymEngine::hash_t> hashes;
+            for (auto &e : exprs) {
+                hashes.push_back(e->hash());
+            }
+            if (consed && hashes != plain_hashes) {
+                throw std::runtime_error("The hash_cons mode produced different exprs");
+            }
+            plain_hashes = hashes;
+
+            exprs.clear();
+            if (consed) {
+                std::cout << "Collected " << table.collect() << " nodes" << std::endl;
+                table.disable();
+                table.clear();
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "symengine/basic.h"
+
+class bench07: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+public:
+    bench07(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        benchmark_base("bench07"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+
+private:
+    /**
+     * Builds n exprs of the bench01 workload, through the hc:: wrappers (which fall back to plain SymEngine when the
+     * unique table is disabled).
+     */
+    SymEngine::vec_basic Generate(size_t n, timer_stats &stats);
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench07/bench07.h"
+
+int main() {
+    bench07 b(1024, 1024*2, 5);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench07 --file mem_usage_bench07.txt | tee /dev/tty
@@ -0,0 +1,103 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <sys/resource.h>
+
+#include "bench08.h"
+#include "bench05/CFileWriter.h"
+#include "utils/expr_builder.h"
+
+static double peak_rss_mb() {
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return static_cast<double>(ru.ru_maxrss) / 1024.0;
+}
+
+void bench08::Preparation() {
+    gen.make_symbols();
+    hashes.resize(cfg_N);
+}
+
+template<typename Writer>
+void bench08::Verify(Writer &writer, size_t retId, const std::string& pipeline) {
+    if (writer.GetElementCount(retId) != cfg_N) {
+        throw std::runtime_error("The " + pipeline + " pipeline wrote " +
+                                 std::to_string(writer.GetElementCount(retId)) + " elements");
+    }
+    for (size_t i = 0; i < cfg_N; i++) {
+        auto tuple = writer.Read(retId, i);
+        if (std::get<0>(tuple) != i || std::get<1>(tuple)->hash() != hashes[i]) {
+            std::cout << "Mismatch in serialization at index " << i << " of the " << pipeline << " pipeline" <<
+                std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+    }
+}
+
+/**
+ * Every expr is written as soon as it is built and is released before the next one is built.
+ */
+void bench08::RunStream() {
+    srand(0);
+    CFileWriter<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench08_stream", false);
+    const auto retId = writer.GenerateRetId();
+    {
+        auto phase = Phase("stream");
+        timer_stats stats("bench08 stream", {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}});
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto expr = gen.generate(builder);
+            hashes[i] = expr->hash();
+            writer.Stream(retId, i, std::move(expr));
+        }
+    }
+    std::cout << "Pipeline stream: " << writer.GetFileSize() << " bytes, peak RSS so far " << peak_rss_mb() << " MB" <<
+        std::endl;
+    Verify(writer, retId, "stream");
+}
+
+/**
+ * All the exprs are built first and are then saved through the shared archive of CFileWriterBase, as bench05 does.
+ */
+void bench08::RunMaterialize() {
+    srand(0);
+    CFileWriterBase<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench08_materialize", false);
+    const auto retId = writer.GenerateRetId();
+    {
+        auto phase = Phase("materialize");
+        timer_stats stats("bench08 materialize", {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}});
+        timer_scope ts(stats);
+        auto exprs = gen.generate(cfg_N);
+        for (size_t i = 0; i < cfg_N; i++) {
+            hashes[i] = exprs[i]->hash();
+            writer.Append(retId, {i, exprs[i]});
+        }
+    }
+    std::cout << "Pipeline materialize: " << writer.GetFileSize() << " bytes, peak RSS so far " << peak_rss_mb() <<
+        " MB" << std::endl;
+    Verify(writer, retId, "materialize");
+}
+
+/**
+ * This benchmark compares two ways of saving N exprs of the form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ *  - stream: generate-and-stream through CFileWriter, at most one expr is alive at a time.
+ *  - materialize: generate all the exprs, then save them through CFileWriterBase.
+ * Both pipelines use the same random exponents and are verified by reading the files back.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ */
+void bench08::Workload() {
+    std::cout << "Saving " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    if (cfg_mode != mode::MATERIALIZE) {
+        RunStream();
+    }
+    if (cfg_mode != mode::STREAM) {
+        RunMaterialize();
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench08: public benchmark_base {
+public:
+    enum class mode {BOTH, STREAM, MATERIALIZE};
+
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    const mode cfg_mode;
+    const std::string storage_dir;
+    sum_of_powers gen;
+    std::vector<SymEngine::hash_t> hashes;
+
+public:
+    /**
+     * @param cfg_mode Run only one of the pipelines, so that the peak RSS of the process (as collected by bench_runner)
+     * belongs to it. With BOTH, the streaming pipeline runs first, as the peak RSS can only grow.
+     */
+    bench08(size_t cfg_N, size_t cfg_L, size_t cfg_P, mode cfg_mode = mode::BOTH,
+            const std::string& storage_dir = "./") :
+        benchmark_base("bench08"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_mode(cfg_mode), storage_dir(storage_dir), gen(cfg_L, cfg_P)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+
+private:
+    void RunStream();
+
+    void RunMaterialize();
+
+    /**
+     * Reads back every element of the RetID and compares it with the hash recorded while generating.
+     */
+    template<typename Writer>
+    void Verify(Writer &writer, size_t retId, const std::string& pipeline);
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench08/bench08.h"
+
+int main() {
+    bench08 b(1024, 1024*2, 5);
+    b.Run();
+
+    return 0;
+}
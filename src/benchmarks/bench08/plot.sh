@@ -0,0 +1,9 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench08 --file mem_usage_bench08.txt | tee /dev/tty
+
+# Peak RSS against N, from a sweep such as:
+#   ./bench_runner --bench bench08_stream --bench bench08_materialize --N 64:4096:x2 --reps 3 --out results
+if [ -f ../bench_runner/results/results.csv ]; then
+  python plot_peak_rss.py --title "bench08 peak RSS" --file ../bench_runner/results/results.csv --bench bench08_stream --bench bench08_materialize | tee /dev/tty
+fi
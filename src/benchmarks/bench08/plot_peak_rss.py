@@ -0,0 +1,46 @@
+import argparse
+import csv
+import os
+from collections import defaultdict
+import seaborn as sns
+import matplotlib.pyplot as plt
+
+def plot_peak_rss(file, benches, title):
+    if not os.path.isfile(file):
+        print(f"File {file} does not exist.")
+        return
+
+    # bench -> N -> list of peak RSS (MB) of the repetitions
+    points = defaultdict(lambda: defaultdict(list))
+    with open(file, 'r') as f:
+        for row in csv.DictReader(f):
+            if row["bench"] not in benches or row["kind"] != "rep" or row["exit_status"] != "0":
+                continue
+            points[row["bench"]][int(row["N"])].append(float(row["max_rss_kb"]) / 1024.0)
+
+    colors = sns.color_palette("RdYlBu", len(benches))
+    fig, ax = plt.subplots(figsize=(12, 6))
+    for idx, bench in enumerate(benches):
+        if not points[bench]:
+            print(f"No successful runs of {bench} in {file}")
+            continue
+        ns = sorted(points[bench])
+        peaks = [max(points[bench][n]) for n in ns]
+        ax.plot(ns, peaks, label=bench, color=colors[idx], marker='o')
+
+    ax.set_xscale("log", base=2)
+    ax.set_xlabel("N")
+    ax.set_ylabel("Peak RSS (MB)")
+    ax.legend(loc="best", fontsize="small")
+    ax.grid(True)
+    fig.suptitle(title, fontsize=16, fontweight='bold')
+    plt.tight_layout(rect=[0, 0, 1, 0.95])
+    plt.show()
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Plot the peak RSS against N from the results.csv of bench_runner.')
+    parser.add_argument('--file', type=str, required=True, help='results.csv of bench_runner')
+    parser.add_argument('--bench', type=str, action='append', required=True, help='Benchmarks to plot')
+    parser.add_argument('--title', type=str, default=None, required=True, help='Title for the figure')
+    args = parser.parse_args()
+    plot_peak_rss(args.file, args.bench, args.title)
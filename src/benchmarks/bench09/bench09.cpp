@@ -0,0 +1,114 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench09.h"
+#include "utils/lazy_sum.h"
+#include "utils/vec_serialization.h"
+
+
+void bench09::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * This benchmark stores N exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * both with `Basic::dumps()` and with `dumps_lazy()`, and runs a query-style workload on them: open every stored expr,
+ * read its number of terms and inspect K of its terms.
+ *  - eager: `Basic::loads()` of the whole expr, then `get_args()`.
+ *  - lazy: `lazy_sum::from_file()`, `size()` and `term(k)`, which only deserializes the K touched terms.
+ * A sample of the exprs is then fully materialized from the lazy form and compared with the eager one.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *  - K: Number of terms touched by the query.
+ */
+void bench09::Workload() {
+    const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    size_t bytes_eager = 0, bytes_lazy = 0;
+    std::cout << "Generating and saving " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P <<
+        std::endl;
+    {
+        auto phase = Phase("expr_save");
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            auto expr = gen.generate(builder);
+            auto eager = expr->dumps();
+            auto lazy = dumps_lazy(expr);
+            write_blob("expr_" + std::to_string(i) + ".bin", eager);
+            write_blob("lazy_" + std::to_string(i) + ".bin", lazy);
+            bytes_eager += eager.size();
+            bytes_lazy += lazy.size();
+        }
+    }
+
+    // The query touches the terms at the same positions in both modes. The order of the args of a loaded Add may differ
+    // from the stored one, so the touched terms themselves are not compared; the hashes only keep the work alive.
+    SymEngine::hash_t touched = 0;
+    size_t terms_eager = 0, terms_lazy = 0;
+    uint64_t read_eager = 0, read_lazy = 0;
+
+    std::cout << "Querying the exprs, eager." << std::endl;
+    {
+        auto phase = Phase("query_eager");
+        timer_stats stats("bench09 query eager", pairs);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto data = read_blob("expr_" + std::to_string(i) + ".bin");
+            read_eager += data.size();
+            auto expr = SymEngine::Basic::loads(data);
+            auto args = expr->get_args();
+            terms_eager += args.size();
+            for (size_t k = 0; k < cfg_K && k < args.size(); k++) {
+                touched ^= args[(k * 7919) % args.size()]->hash();
+            }
+        }
+    }
+
+    std::cout << "Querying the exprs, lazy." << std::endl;
+    {
+        auto phase = Phase("query_lazy");
+        timer_stats stats("bench09 query lazy", pairs);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto sum = lazy_sum::from_file("lazy_" + std::to_string(i) + ".bin");
+            terms_lazy += sum.size();
+            for (size_t k = 0; k < cfg_K && k < sum.size(); k++) {
+                touched ^= sum.term((k * 7919) % sum.size())->hash();
+            }
+            read_lazy += sum.bytes_read();
+        }
+    }
+    if (terms_eager != terms_lazy) {
+        throw std::runtime_error("The lazy form has " + std::to_string(terms_lazy) + " terms instead of " +
+                                 std::to_string(terms_eager));
+    }
+
+    std::cout << "Materializing a sample of the lazy exprs." << std::endl;
+    {
+        auto phase = Phase("materialize");
+        timer_stats stats("bench09 materialize", pairs);
+        for (size_t i = 0; i < cfg_N; i += std::max<size_t>(1, cfg_N / 16)) {
+            auto eager = SymEngine::Basic::loads(read_blob("expr_" + std::to_string(i) + ".bin"));
+            SymEngine::RCP<const SymEngine::Basic> lazy;
+            {
+                timer_scope ts(stats);
+                lazy = lazy_sum::from_file("lazy_" + std::to_string(i) + ".bin").materialize();
+            }
+            if (not SymEngine::eq(*eager, *lazy)) {
+                std::cout << "Mismatch in serialization at index " << i << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+    }
+
+    std::cout << "============================================" << std::endl;
+    std::cout << "> Stored bytes, eager: " << bytes_eager << ", lazy: " << bytes_lazy << std::endl;
+    std::cout << "> Bytes read by the query, eager: " << read_eager << ", lazy: " << read_lazy << std::endl;
+    std::cout << "> Terms seen by the query: " << terms_lazy << ", touched per expr: " << cfg_K << " (" << touched << ")" <<
+        std::endl;
+    std::cout << "============================================" << std::endl;
+}
@@ -0,0 +1,26 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench09: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    // The number of terms a query touches per expr.
+    const size_t cfg_K;
+    sum_of_powers gen;
+public:
+    bench09(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_K = 4) :
+        benchmark_base("bench09"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_K(cfg_K), gen(cfg_L, cfg_P)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench09/bench09.h"
+
+int main() {
+    bench09 b(1024, 1024*4, 5);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench09 --file mem_usage_bench09.txt | tee /dev/tty
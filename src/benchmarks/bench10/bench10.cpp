@@ -0,0 +1,118 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench10.h"
+#include "symengine/expand.h"
+#include "utils/poly_codec.h"
+#include "utils/vec_serialization.h"
+#include "utils/visitor_sym.h"
+
+
+void bench10::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * This benchmark is bench01 with expand enabled: it constructs N number of exprs of form:
+ *  expr_i = expand(Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P))
+ * and saves/loads them through `Basic::dumps()`/`loads()` and through the sparse polynomial format of
+ * `utils/poly_codec.h`.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr (before expanding).
+ *  - P: Power of each term.
+ *
+ */
+void bench10::Workload() {
+    const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    auto heap = []() {
+        return static_cast<double>(phase_profiler::read_memory_counters().heap_in_use_bytes) / 1048576.0;
+    };
+
+    SymEngine::vec_basic exprs;
+    std::vector<SymEngine::hash_t> hashes;
+    std::cout << "Generating " << cfg_N << " expanded expressions of length " << cfg_L << " and power " << cfg_P <<
+        std::endl;
+    const double heap_before_gen = heap();
+    {
+        auto phase = Phase("expr_gen");
+        timer_stats stats("bench10 expand", pairs);
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            auto expr = gen.generate(builder);
+            timer_scope ts(stats);
+            exprs.push_back(SymEngine::expand(expr));
+        }
+    }
+    const double footprint_gen = heap() - heap_before_gen;
+    size_t monomials = 0;
+    for (auto &e : exprs) {
+        hashes.push_back(e->hash());
+        monomials += e->get_args().size();
+    }
+    std::cout << "Number of monomials: " << monomials << ", unique nodes: " << count_unique_nodes(exprs) << std::endl;
+
+    size_t bytes_dumps = 0, bytes_poly = 0;
+    std::cout << "Saving the exprs onto the disk." << std::endl;
+    {
+        auto phase = Phase("save_dumps");
+        timer_stats stats("bench10 save dumps", pairs);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto data = exprs[i]->dumps();
+            write_blob("expr_" + std::to_string(i) + ".bin", data);
+            bytes_dumps += data.size();
+        }
+    }
+    {
+        auto phase = Phase("save_poly");
+        timer_stats stats("bench10 save poly", pairs);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto data = dumps_poly(exprs[i]);
+            write_blob("poly_" + std::to_string(i) + ".bin", data);
+            bytes_poly += data.size();
+        }
+    }
+
+    std::cout << "Wiping everything" << std::endl;
+    exprs.clear();
+
+    auto load = [&](const std::string& mode, const std::string& prefix,
+                    SymEngine::RCP<const SymEngine::Basic> (*loader)(const std::string&)) {
+        const double heap_before = heap();
+        SymEngine::vec_basic loaded;
+        {
+            auto phase = Phase("load_" + mode);
+            timer_stats stats("bench10 load " + mode, pairs);
+            for (size_t i = 0; i < cfg_N; i++) {
+                auto data = read_blob(prefix + std::to_string(i) + ".bin");
+                timer_scope ts(stats);
+                loaded.push_back(loader(data));
+            }
+        }
+        const double footprint = heap() - heap_before;
+        for (size_t i = 0; i < cfg_N; i++) {
+            if (loaded[i]->hash() != hashes[i]) {
+                std::cout << "Mismatch in serialization at index " << i << " of mode " << mode << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+        return footprint;
+    };
+    std::cout << "Loading the exprs from the disk." << std::endl;
+    const double footprint_dumps = load("dumps", "expr_", [](const std::string& data) {
+        return SymEngine::Basic::loads(data);
+    });
+    const double footprint_poly = load("poly", "poly_", [](const std::string& data) {
+        return loads_poly(data);
+    });
+
+    std::cout << "============================================" << std::endl;
+    std::cout << "> Heap after expanding (MB):\t" << footprint_gen << std::endl;
+    std::cout << "> dumps:\t" << bytes_dumps << " bytes, heap after load (MB): " << footprint_dumps << std::endl;
+    std::cout << "> poly: \t" << bytes_poly << " bytes, heap after load (MB): " << footprint_poly << std::endl;
+    std::cout << "============================================" << std::endl;
+}
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench10/bench10.h"
+
+int main() {
+    bench10 b(4, 64, 5);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
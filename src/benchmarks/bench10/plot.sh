@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench10 --file mem_usage_bench10.txt | tee /dev/tty
@@ -0,0 +1,71 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench11.h"
+#include "sum_of_powers.h"
+#include "symengine/expand.h"
+#include "utils/parallel_expand.h"
+
+
+void bench11::Preparation() {
+#ifndef WITH_SYMENGINE_THREAD_SAFE
+    // parallel_expand() would fall back to expand() and the benchmark would time serial against serial.
+    throw std::runtime_error("bench11 needs SymEngine with WITH_SYMENGINE_THREAD_SAFE=ON, run bench11_atomic_main "
+                             "(-DSYMENGINE_BENCH_THREAD_SAFE=ON)");
+#endif
+}
+
+/**
+ * This benchmark compares SymEngine::expand() with parallel_expand() on exprs of form:
+ *  expr = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * for L = 64, 256, ..., cfg_L and P = 5, 10, ..., cfg_P. Both expand the same N exprs and their results are compared.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs per point.
+ *  - L: Largest number of terms in each expr.
+ *  - P: Largest power of each term.
+ */
+void bench11::Workload() {
+    const size_t threads = cfg_T == 0 ? std::max(1u, std::thread::hardware_concurrency()) : cfg_T;
+    std::cout << "Expanding with " << threads << " threads" << std::endl;
+    for (size_t L = 64; L <= cfg_L; L *= 4) {
+        for (size_t P = std::min<size_t>(5, cfg_P); P <= cfg_P; P += 5) {
+            const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)L}, {"P", (int)P},
+                                                      {"T", (int)threads}};
+            sum_of_powers gen(L, P);
+            gen.make_symbols();
+            const auto exprs = gen.generate(cfg_N);
+
+            SymEngine::vec_basic serial, parallel;
+            timer_stats stats_serial("bench11 serial", pairs);
+            timer_stats stats_parallel("bench11 parallel", pairs);
+            {
+                auto phase = Phase("serial_L" + std::to_string(L) + "_P" + std::to_string(P));
+                for (auto &e : exprs) {
+                    timer_scope ts(stats_serial);
+                    serial.push_back(SymEngine::expand(e));
+                }
+            }
+            {
+                auto phase = Phase("parallel_L" + std::to_string(L) + "_P" + std::to_string(P));
+                for (auto &e : exprs) {
+                    timer_scope ts(stats_parallel);
+                    parallel.push_back(parallel_expand(e, threads));
+                }
+            }
+            for (size_t i = 0; i < cfg_N; i++) {
+                if (not SymEngine::eq(*serial[i], *parallel[i])) {
+                    std::cout << "Mismatch in expansion at index " << i << " for L=" << L << " P=" << P << std::endl;
+                    throw std::runtime_error("Expansion mismatch");
+                }
+            }
+            // The samples are still in the shards of the recording thread.
+            stats_serial.flush_threads();
+            stats_parallel.flush_threads();
+            std::cout << "L=" << L << " P=" << P << ": " << serial[0]->get_args().size() << " monomials, " <<
+                "mean serial " << stats_serial.ave() << " ms, mean parallel " << stats_parallel.ave() << " ms, " <<
+                "speedup x" << stats_serial.ave() / stats_parallel.ave() << std::endl;
+        }
+    }
+}
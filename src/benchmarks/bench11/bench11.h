@@ -0,0 +1,24 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "symengine/basic.h"
+
+class bench11: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    // The number of workers of parallel_expand(), all the hardware threads if 0.
+    const size_t cfg_T;
+public:
+    bench11(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_T = 0) :
+        benchmark_base("bench11"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_T(cfg_T)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench11/bench11.h"
+
+int main() {
+    bench11 b(4, 4096, 15);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench11 --file mem_usage_bench11.txt | tee /dev/tty
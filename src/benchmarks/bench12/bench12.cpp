@@ -0,0 +1,151 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <functional>
+
+#include "bench12.h"
+#include "utils/symtab_codec.h"
+#include "utils/vec_serialization.h"
+
+
+void bench12::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * This benchmark constructs N number of exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * with the symbols named after their id, as bench05 does, and compares storing the names of the symbols as strings
+ * with storing them once in a symbol table (utils/symtab_codec.h):
+ *  - per_expr_dumps: one `Basic::dumps()` record per expr, every record carries all the names.
+ *  - per_expr_symtab: one `dumps_symtab(expr, table)` record per expr and one table for all of them.
+ *  - vec_dumps: the whole vec_basic through one cereal archive (`dumps_vec()`).
+ *  - vec_symtab: the whole vec_basic through `dumps_symtab()`, with its table embedded.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr, 3L symbols in total.
+ *  - P: Power of each term.
+ *
+ */
+void bench12::Workload() {
+    const std::map<std::string, int> pairs = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    auto heap = []() {
+        return static_cast<double>(phase_profiler::read_memory_counters().heap_in_use_bytes) / 1048576.0;
+    };
+
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    SymEngine::vec_basic exprs;
+    {
+        auto phase = Phase("expr_gen");
+        exprs = gen.generate(cfg_N);
+    }
+    std::vector<SymEngine::hash_t> hashes;
+    for (auto &e : exprs) {
+        hashes.push_back(e->hash());
+    }
+
+    std::cout << "Saving the exprs onto the disk." << std::endl;
+    size_t bytes_dumps = 0, bytes_symtab = 0;
+    {
+        auto phase = Phase("save_per_expr_dumps");
+        timer_stats stats("bench12 save per_expr_dumps", pairs);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto data = exprs[i]->dumps();
+            write_blob("expr_" + std::to_string(i) + ".bin", data);
+            bytes_dumps += data.size();
+        }
+    }
+    {
+        auto phase = Phase("save_per_expr_symtab");
+        timer_stats stats("bench12 save per_expr_symtab", pairs);
+        symbol_table table;
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            auto data = dumps_symtab({exprs[i]}, table);
+            write_blob("symtab_" + std::to_string(i) + ".bin", data);
+            bytes_symtab += data.size();
+        }
+        auto data = table.dumps();
+        write_blob("symtab_table.bin", data);
+        bytes_symtab += data.size();
+    }
+    size_t bytes_vec_dumps, bytes_vec_symtab;
+    {
+        auto phase = Phase("save_vec_dumps");
+        timer_stats stats("bench12 save vec_dumps", pairs);
+        timer_scope ts(stats);
+        auto data = dumps_vec(exprs);
+        write_blob("vec_dumps.bin", data);
+        bytes_vec_dumps = data.size();
+    }
+    {
+        auto phase = Phase("save_vec_symtab");
+        timer_stats stats("bench12 save vec_symtab", pairs);
+        timer_scope ts(stats);
+        auto data = dumps_symtab(exprs);
+        write_blob("vec_symtab.bin", data);
+        bytes_vec_symtab = data.size();
+    }
+
+    std::cout << "Wiping everything" << std::endl;
+    exprs.clear();
+    gen.clear();
+
+    auto verify = [&](const SymEngine::vec_basic& loaded, const std::string& mode) {
+        for (size_t i = 0; i < cfg_N; i++) {
+            if (loaded.size() != cfg_N || loaded[i]->hash() != hashes[i]) {
+                std::cout << "Mismatch in serialization at index " << i << " of mode " << mode << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+    };
+    // Every mode loads into a fresh heap state: what it loaded is dropped before the next one starts.
+    auto run_load = [&](const std::string& mode, const std::function<SymEngine::vec_basic()>& load) {
+        const double heap_before = heap();
+        SymEngine::vec_basic loaded;
+        {
+            auto phase = Phase("load_" + mode);
+            timer_stats stats("bench12 load " + mode, pairs);
+            timer_scope ts(stats);
+            loaded = load();
+        }
+        const double footprint = heap() - heap_before;
+        verify(loaded, mode);
+        return footprint;
+    };
+
+    std::cout << "Loading the exprs from the disk." << std::endl;
+    const double heap_dumps = run_load("per_expr_dumps", [&]() {
+        SymEngine::vec_basic loaded;
+        for (size_t i = 0; i < cfg_N; i++) {
+            loaded.push_back(SymEngine::Basic::loads(read_blob("expr_" + std::to_string(i) + ".bin")));
+        }
+        return loaded;
+    });
+    const double heap_symtab = run_load("per_expr_symtab", [&]() {
+        const auto table = symbol_table::loads(read_blob("symtab_table.bin"));
+        SymEngine::vec_basic loaded;
+        for (size_t i = 0; i < cfg_N; i++) {
+            loaded.push_back(loads_symtab(read_blob("symtab_" + std::to_string(i) + ".bin"), table)[0]);
+        }
+        return loaded;
+    });
+    const double heap_vec_dumps = run_load("vec_dumps", [&]() {
+        return loads_vec(read_blob("vec_dumps.bin"));
+    });
+    const double heap_vec_symtab = run_load("vec_symtab", [&]() {
+        return loads_symtab(read_blob("vec_symtab.bin"));
+    });
+
+    std::cout << "============================================" << std::endl;
+    std::cout << "> per_expr_dumps: \t" << bytes_dumps << " bytes, heap after load (MB): " << heap_dumps << std::endl;
+    std::cout << "> per_expr_symtab:\t" << bytes_symtab << " bytes, heap after load (MB): " << heap_symtab << std::endl;
+    std::cout << "> vec_dumps:      \t" << bytes_vec_dumps << " bytes, heap after load (MB): " << heap_vec_dumps <<
+        std::endl;
+    std::cout << "> vec_symtab:     \t" << bytes_vec_symtab << " bytes, heap after load (MB): " << heap_vec_symtab <<
+        std::endl;
+    std::cout << "============================================" << std::endl;
+}
@@ -0,0 +1,24 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench12: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    sum_of_powers gen;
+public:
+    bench12(size_t cfg_N, size_t cfg_L, size_t cfg_P) :
+        benchmark_base("bench12"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
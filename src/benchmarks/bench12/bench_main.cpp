@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench12/bench12.h"
+
+int main() {
+    bench12 b(64, 1024*64, 5);
+    b.Run();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench12 --file mem_usage_bench12.txt | tee /dev/tty
@@ -0,0 +1,83 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench13.h"
+#include "bench05/CFileWriterBase.h"
+#include "utils/vec_serialization.h"
+#include "utils/visitor_sym.h"
+
+using writer_t = CFileWriterBase<size_t, SymEngine::RCP<const SymEngine::Basic>>;
+
+void bench13::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * This benchmark walks all the elements of a RetID of N exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * with a `Read(retId, i)` loop and with `Scan()`, with the file evicted from the page cache (cold) and read once
+ * beforehand (warm), for both the self-contained and the shared-archive layouts of CFileWriterBase. The consumer counts
+ * the unique nodes of every element, which is the work Scan() overlaps with the I/O.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ */
+void bench13::Workload() {
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    writer_t self_contained(storage_dir, "bench13_self_contained", false, false, true);
+    writer_t shared(storage_dir, "bench13_shared", false, false, false);
+    {
+        auto phase = Phase("expr_save");
+        auto exprs = gen.generate(cfg_N);
+        self_contained.GenerateRetId();
+        shared.GenerateRetId();
+        for (size_t i = 0; i < cfg_N; i++) {
+            hashes.push_back(exprs[i]->hash());
+            self_contained.Append(0, {i, exprs[i]});
+            shared.Append(0, {i, exprs[i]});
+        }
+    }
+
+    size_t checksum = 0;
+    auto consume = [&](const std::tuple<size_t, SymEngine::RCP<const SymEngine::Basic>>& e, size_t i) {
+        if (std::get<0>(e) != i || std::get<1>(e)->hash() != hashes[i]) {
+            std::cout << "Mismatch in serialization at index " << i << std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+        checksum += count_unique_nodes({std::get<1>(e)});
+    };
+
+    for (auto *writer : {&self_contained, &shared}) {
+        const std::string layout = writer == &self_contained ? "self_contained" : "shared";
+        writer->Flush();
+        for (const std::string cache : {"cold", "warm"}) {
+            for (const std::string method : {"read", "scan"}) {
+                if (cache == "cold") {
+                    writer->DropPageCache();
+                } else {
+                    read_blob(writer->GetBinPath());
+                }
+                const std::string mode = layout + "_" + cache + "_" + method;
+                std::cout << "Walking the RetID, " << mode << std::endl;
+                auto phase = Phase(mode);
+                timer_stats stats("bench13 " + mode, {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}});
+                timer_scope ts(stats);
+                if (method == "read") {
+                    for (size_t i = 0; i < cfg_N; i++) {
+                        consume(writer->Read(0, i), i);
+                    }
+                } else {
+                    auto scan = writer->Scan(0, 0, cfg_N);
+                    std::tuple<size_t, SymEngine::RCP<const SymEngine::Basic>> e;
+                    for (size_t i = 0; scan->Next(e); i++) {
+                        consume(e, i);
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "Unique nodes seen: " << checksum << std::endl;
+}
@@ -0,0 +1,26 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench13: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P;
+    const std::string storage_dir;
+    sum_of_powers gen;
+    std::vector<SymEngine::hash_t> hashes;
+public:
+    bench13(size_t cfg_N, size_t cfg_L, size_t cfg_P, const std::string& storage_dir = "./") :
+        benchmark_base("bench13"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), storage_dir(storage_dir), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
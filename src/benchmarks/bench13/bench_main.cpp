@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench13/bench13.h"
+
+int main() {
+    bench13 b(1024, 1024*4, 5);
+    b.Run();
+
+    return 0;
+}
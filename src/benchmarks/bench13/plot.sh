@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench13 --file mem_usage_bench13.txt | tee /dev/tty
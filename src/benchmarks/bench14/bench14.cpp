@@ -0,0 +1,80 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench14.h"
+#include "bench05/CFileWriter.h"
+
+void bench14::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * Appends N states of form:
+ *  state_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * where every state is repeated R times in a row, like the checkpoints of a converged pipeline. Every repetition is
+ * rebuilt from the same seed, so the repeated states are structurally identical but do not share any node but the
+ * symbols. The states are appended through a CFileWriter with and without deduplication and are read back.
+ *
+ *  So our parameters are:
+ *  - N: Number of appended states.
+ *  - L: Number of terms in each state.
+ *  - P: Power of each term.
+ *  - R: Number of repetitions of each state.
+ */
+void bench14::RunSuite(bool dedup) {
+    const std::string mode = dedup ? "dedup" : "plain";
+    const std::map<std::string, int> params = {
+        {"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"R", (int)cfg_R}
+    };
+    std::cout << "Appending " << cfg_N << " states, " << mode << std::endl;
+    auto phase = Phase(mode);
+    CFileWriter<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench14_" + mode, false, false,
+                                                                       dedup);
+    const auto retId = writer.GenerateRetId();
+    std::vector<SymEngine::hash_t> hashes;
+    {
+        timer_stats stats("bench14 append " + mode, params);
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            srand(static_cast<unsigned>(i / cfg_R));
+            auto state = gen.generate(builder);
+            hashes.push_back(state->hash());
+            timer_scope ts(stats);
+            writer.Stream(retId, i, std::move(state));
+        }
+    }
+
+    {
+        timer_stats stats("bench14 read " + mode, params);
+        timer_scope ts(stats);
+        for (size_t i = 0; i < cfg_N; i++) {
+            auto [index, state] = writer.Read(retId, i);
+            if (state->hash() != hashes[i]) {
+                std::cout << "Mismatch in serialization at index " << i << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+    }
+
+    std::cout << "File size (" << mode << "): " << writer.GetFileSize() << " bytes" << std::endl;
+    if (dedup) {
+        const auto st = writer.GetDedupStats();
+        std::cout << "Dedup hits: " << st.hits << " / " << st.appends << " (ratio " << st.DedupRatio() << ")" <<
+            std::endl;
+        std::cout << "Bytes written: " << st.bytesWritten << ", bytes saved: " << st.bytesSaved << std::endl;
+        std::cout << "Hashing cost per append: " << st.HashNanosPerAppend() << " ns" << std::endl;
+        // Every state but the first of each run of R repetitions is a hit.
+        const size_t expected = cfg_N - (cfg_N + cfg_R - 1) / cfg_R;
+        if (st.hits != expected) {
+            std::cout << "Expected " << expected << " dedup hits, got " << st.hits << std::endl;
+            throw std::runtime_error("Dedup mismatch");
+        }
+    }
+    writer.Nuke();
+}
+
+void bench14::Workload() {
+    RunSuite(false);
+    RunSuite(true);
+}
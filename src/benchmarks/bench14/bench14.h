@@ -0,0 +1,30 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench14: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P, cfg_R;
+    const std::string storage_dir;
+    sum_of_powers gen;
+
+    void RunSuite(bool dedup);
+public:
+    /**
+     * @param cfg_R The number of consecutive appends of every state.
+     */
+    bench14(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_R = 4, const std::string& storage_dir = "./") :
+        benchmark_base("bench14"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_R(cfg_R), storage_dir(storage_dir), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
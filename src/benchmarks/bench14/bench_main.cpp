@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench14/bench14.h"
+
+int main() {
+    bench14 b(1024, 1024*2, 5, 4);
+    b.Run();
+
+    return 0;
+}
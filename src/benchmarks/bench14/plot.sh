@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench14 --file mem_usage_bench14.txt | tee /dev/tty
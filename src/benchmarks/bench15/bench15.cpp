@@ -0,0 +1,88 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench15.h"
+#include "bench05/CFileWriter.h"
+
+void bench15::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * A bench05 variant for a long-running job with short-lived retIds, on the N exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * Every round appends all the exprs to N/16 new retIds of 16 elements, then erases 3 out of 4 of them and truncates
+ * the last one to 8 elements. The space amplification (file size / live bytes) is reported after every round. Every
+ * other round, the file is compacted on a background thread while the live retIds are read back and verified.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs appended per round.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *  - R: Number of rounds.
+ */
+void bench15::Workload() {
+    constexpr size_t RETID_SIZE = 16;
+    const std::map<std::string, int> params = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}};
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    {
+        auto phase = Phase("expr_gen");
+        exprs = gen.generate(cfg_N);
+    }
+
+    CFileWriter<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench15", false);
+    // The live retIds and their number of elements.
+    std::vector<std::pair<size_t, size_t>> live;
+    auto verify = [&]() {
+        for (const auto &[retId, n] : live) {
+            for (size_t i = 0; i < n; i++) {
+                auto [index, expr] = writer.Read(retId, i);
+                if (index != i || expr->hash() != exprs[(retId * RETID_SIZE + i) % cfg_N]->hash()) {
+                    std::cout << "Mismatch in serialization at index " << i << " of RetID " << retId << std::endl;
+                    throw std::runtime_error("Serialization mismatch");
+                }
+            }
+        }
+    };
+
+    timer_stats stats_append("bench15 append", params);
+    timer_stats stats_compact("bench15 compact", params);
+    timer_stats stats_read("bench15 read during compaction", params);
+    for (size_t round = 0; round < cfg_R; round++) {
+        {
+            auto phase = Phase("append");
+            timer_scope ts(stats_append);
+            for (size_t k = 0; k < cfg_N / RETID_SIZE; k++) {
+                const auto retId = writer.GenerateRetId();
+                for (size_t i = 0; i < RETID_SIZE; i++) {
+                    writer.Append(retId, {i, exprs[(retId * RETID_SIZE + i) % cfg_N]});
+                }
+                if (k % 4 != 3) {
+                    writer.Erase(retId);
+                } else {
+                    writer.Truncate(retId, RETID_SIZE / 2);
+                    live.emplace_back(retId, RETID_SIZE / 2);
+                }
+            }
+        }
+        std::cout << "Round " << round << ": file size " << writer.GetFileSize() << " bytes, space amplification " <<
+            writer.GetSpaceAmplification() << std::endl;
+
+        if (round % 2 == 1) {
+            auto phase = Phase("compact");
+            timer_scope ts(stats_compact);
+            auto compaction = writer.CompactAsync();
+            {
+                timer_scope ts_read(stats_read);
+                verify();
+            }
+            const auto st = compaction.get();
+            std::cout << "Compacted " << st.bytesBefore << " bytes into " << st.bytesAfter << " bytes (" <<
+                st.recordsCopied << " records in " << st.runsCopied << " runs) in " << st.seconds << " s (" <<
+                st.ThroughputMBps() << " MB/s), space amplification " << writer.GetSpaceAmplification() << std::endl;
+        }
+    }
+    verify();
+    writer.Nuke();
+}
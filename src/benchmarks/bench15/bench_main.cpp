@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench15/bench15.h"
+
+int main() {
+    bench15 b(1024, 1024, 5, 8);
+    b.Run();
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench15 --file mem_usage_bench15.txt | tee /dev/tty
@@ -0,0 +1,93 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <thread>
+
+#include "bench16.h"
+#include "bench05/CShardedFileWriter.h"
+#include "symengine/symengine_config.h"
+
+using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+void bench16::Preparation() {
+#ifndef WITH_SYMENGINE_THREAD_SAFE
+    // The writer threads share the symbols of the exprs: the sweep would never go past a single thread.
+    throw std::runtime_error("bench16 needs SymEngine with WITH_SYMENGINE_THREAD_SAFE=ON, run bench16_atomic_main "
+                             "(-DSYMENGINE_BENCH_THREAD_SAFE=ON)");
+#endif
+    gen.make_symbols();
+    exprs = gen.generate(cfg_N);
+}
+
+/**
+ * T writer threads append the N exprs, each thread its own slice to its own RetID, through:
+ *  - `single`: one CFileWriterBase shared by all the threads.
+ *  - `sharded_retid`: a CShardedFileWriter with T segments, sharded by RetID.
+ *  - `sharded_thread`: a CShardedFileWriter with T segments, sharded by writer thread.
+ * The records are self-contained in all the modes. The exprs are read back and verified after every run.
+ */
+void bench16::RunSuite(const std::string& mode, size_t threads) {
+    const std::map<std::string, int> params = {
+        {"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"T", (int)threads}
+    };
+    const std::string name = "bench16_" + mode;
+    std::unique_ptr<CFileWriterBase<size_t, rcp_basic>> single;
+    std::unique_ptr<CShardedFileWriter<size_t, rcp_basic>> sharded;
+    if (mode == "single") {
+        single = std::make_unique<CFileWriterBase<size_t, rcp_basic>>(storage_dir, name, false, false, true);
+    } else {
+        sharded = std::make_unique<CShardedFileWriter<size_t, rcp_basic>>(
+            storage_dir, name, threads, mode == "sharded_retid" ? ShardBy::RETID : ShardBy::THREAD, false, true);
+    }
+
+    std::vector<size_t> retIds(threads);
+    {
+        auto phase = Phase(mode + "_T" + std::to_string(threads));
+        timer_stats stats("bench16 append " + mode, params);
+        timer_scope ts(stats);
+        std::vector<std::thread> writers;
+        for (size_t t = 0; t < threads; t++) {
+            writers.emplace_back([&, t]() {
+                retIds[t] = single ? single->GenerateRetId() : sharded->GenerateRetId();
+                for (size_t i = t; i < cfg_N; i += threads) {
+                    if (single) {
+                        single->Append(retIds[t], {i, exprs[i]});
+                    } else {
+                        sharded->Append(retIds[t], {i, exprs[i]});
+                    }
+                }
+            });
+        }
+        for (auto &w : writers) {
+            w.join();
+        }
+    }
+    const size_t bytes = single ? single->GetFileSize() : sharded->GetFileSize();
+    std::cout << mode << ", T = " << threads << ": " << bytes << " bytes written" << std::endl;
+
+    for (size_t t = 0; t < threads; t++) {
+        size_t k = 0;
+        for (size_t i = t; i < cfg_N; i += threads, k++) {
+            auto [index, expr] = single ? single->Read(retIds[t], k) : sharded->Read(retIds[t], k);
+            if (index != i || expr->hash() != exprs[i]->hash()) {
+                std::cout << "Mismatch in serialization at index " << i << std::endl;
+                throw std::runtime_error("Serialization mismatch");
+            }
+        }
+    }
+    if (single) {
+        single->Nuke();
+    } else {
+        sharded->Nuke();
+    }
+}
+
+void bench16::Workload() {
+    const size_t max_threads = cfg_T == 0 ? std::max(1u, std::thread::hardware_concurrency()) : cfg_T;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        for (const std::string mode : {"single", "sharded_retid", "sharded_thread"}) {
+            RunSuite(mode, threads);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench16: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P, cfg_T;
+    const std::string storage_dir;
+    sum_of_powers gen;
+    SymEngine::vec_basic exprs;
+
+    void RunSuite(const std::string& mode, size_t threads);
+public:
+    /**
+     * @param cfg_T The largest number of writer threads of the sweep, all the hardware threads if 0.
+     */
+    bench16(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_T = 0, const std::string& storage_dir = "./") :
+        benchmark_base("bench16"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_T(cfg_T), storage_dir(storage_dir), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench16/bench16.h"
+
+int main() {
+    bench16 b(1024, 1024, 5);
+    b.Run();
+
+    return 0;
+}
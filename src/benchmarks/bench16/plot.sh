@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench16 --file mem_usage_bench16.txt | tee /dev/tty
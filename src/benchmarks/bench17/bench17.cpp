@@ -0,0 +1,98 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <thread>
+
+#include "bench17.h"
+#include "bench05/CFileWriter.h"
+#include "utils/vec_serialization.h"
+
+void bench17::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * Stores N exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * over 16 RetIDs through a CFileWriter, then fetches a batch of K scattered (retId, stateIndex) pairs with a `Read()`
+ * loop and with `ReadMany()`, with the file evicted from the page cache (cold) and read once beforehand (warm).
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *  - K: Number of pairs in the batch.
+ * The number of threads that deserialize the batch of `ReadMany()` is recorded as T.
+ */
+void bench17::Workload() {
+    constexpr size_t RETIDS = 16;
+#ifdef WITH_SYMENGINE_THREAD_SAFE
+    const size_t decodeThreads = std::max(1u, std::thread::hardware_concurrency());
+#else
+    const size_t decodeThreads = 1;
+    std::cout << "bench17: SymEngine is not built with WITH_SYMENGINE_THREAD_SAFE, so ReadMany() deserializes on a "
+        "single thread and only its I/O is batched. The parallel decode is measured by bench17_atomic_main "
+        "(-DSYMENGINE_BENCH_THREAD_SAFE=ON)." << std::endl;
+#endif
+    const std::map<std::string, int> params = {
+        {"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"K", (int)cfg_K}, {"T", (int)decodeThreads}
+    };
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    CFileWriter<size_t, SymEngine::RCP<const SymEngine::Basic>> writer(storage_dir, "bench17", false);
+    {
+        auto phase = Phase("expr_save");
+        add_builder builder(cfg_L);
+        for (size_t r = 0; r < RETIDS; r++) {
+            writer.GenerateRetId();
+        }
+        for (size_t i = 0; i < cfg_N; i++) {
+            auto expr = gen.generate(builder);
+            hashes.push_back(expr->hash());
+            writer.Stream(i % RETIDS, i, std::move(expr));
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> requests;
+    for (size_t k = 0; k < cfg_K; k++) {
+        const size_t i = sum_of_powers::get_random_integer(0, cfg_N - 1);
+        requests.emplace_back(i % RETIDS, i / RETIDS);
+    }
+    auto verify = [&](size_t k, const std::tuple<size_t, SymEngine::RCP<const SymEngine::Basic>>& e) {
+        const size_t i = requests[k].second * RETIDS + requests[k].first;
+        if (std::get<0>(e) != i || std::get<1>(e)->hash() != hashes[i]) {
+            std::cout << "Mismatch in serialization at request " << k << std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+    };
+
+    for (const std::string cache : {"cold", "warm"}) {
+        for (const std::string method : {"read", "read_many"}) {
+            if (cache == "cold") {
+                writer.DropPageCache();
+            } else {
+                read_blob(writer.GetBinPath());
+            }
+            const std::string mode = cache + "_" + method;
+            std::cout << "Fetching " << cfg_K << " pairs, " << mode;
+            if (method == "read_many") {
+                std::cout << ", deserialized on " << decodeThreads << " threads";
+            }
+            std::cout << std::endl;
+            auto phase = Phase(mode);
+            timer_stats stats("bench17 " + mode, params);
+            timer_scope ts(stats);
+            if (method == "read") {
+                for (size_t k = 0; k < requests.size(); k++) {
+                    verify(k, writer.Read(requests[k].first, requests[k].second));
+                }
+            } else {
+                const auto results = writer.ReadMany(requests, decodeThreads);
+                for (size_t k = 0; k < requests.size(); k++) {
+                    verify(k, results[k]);
+                }
+            }
+        }
+    }
+    writer.Nuke();
+}
@@ -0,0 +1,29 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench17: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P, cfg_K;
+    const std::string storage_dir;
+    sum_of_powers gen;
+    std::vector<SymEngine::hash_t> hashes;
+public:
+    /**
+     * @param cfg_K The number of (retId, stateIndex) pairs fetched per batch.
+     */
+    bench17(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_K = 2048, const std::string& storage_dir = "./") :
+        benchmark_base("bench17"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_K(cfg_K), storage_dir(storage_dir), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
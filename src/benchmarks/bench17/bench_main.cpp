@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench17/bench17.h"
+
+int main() {
+    bench17 b(4096, 256, 5, 2048);
+    b.Run();
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench17 --file mem_usage_bench17.txt | tee /dev/tty
@@ -0,0 +1,118 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench18.h"
+#include "bench05/CFileWriter.h"
+#include "bench05/CDeltaFileWriter.h"
+
+void bench18::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * Appends N states of form:
+ *  state_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^e_j
+ * round robin over 8 RetIDs. The first state of every RetID draws every e_j from [1, P], and every next state of the
+ * RetID redraws L/32 + 1 random exponents of its predecessor, like the successive states of an iterative pipeline.
+ * The states are appended through a plain CFileWriter and through a CDeltaFileWriter with keyframe interval K, and are
+ * read back in order and at random.
+ *
+ *  So our parameters are:
+ *  - N: Number of appended states.
+ *  - L: Number of terms in each state.
+ *  - P: Power of each term.
+ *  - K: Keyframe interval of the delta-encoded writer.
+ */
+void bench18::Workload() {
+    constexpr size_t RETIDS = 8;
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+    const std::map<std::string, int> params = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"K", (int)cfg_K}};
+    const size_t changes = cfg_L / 32 + 1;
+
+    CFileWriter<size_t, rcp_basic> plain(storage_dir, "bench18_plain", false);
+    CDeltaFileWriter delta(storage_dir, "bench18_delta", static_cast<uint32_t>(cfg_K));
+    for (size_t r = 0; r < RETIDS; r++) {
+        plain.GenerateRetId();
+        delta.GenerateRetId();
+    }
+
+    std::cout << "Appending " << cfg_N << " states of length " << cfg_L << ", " << changes << " changed terms per step"
+        << std::endl;
+    {
+        auto phase = Phase("append");
+        timer_stats statsPlain("bench18 append plain", params);
+        timer_stats statsDelta("bench18 append delta", params);
+        std::vector<rcp_basic> bases;
+        for (size_t j = 0; j < cfg_L; j++) {
+            bases.push_back(gen.base(j));
+        }
+        // The terms of the last state of every RetID; the unchanged terms are shared by the next state.
+        std::vector<SymEngine::vec_basic> terms(RETIDS);
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            const size_t retId = i % RETIDS;
+            auto &t = terms[retId];
+            if (t.empty()) {
+                for (size_t j = 0; j < cfg_L; j++) {
+                    t.push_back(SymEngine::pow(bases[j], SymEngine::integer(sum_of_powers::get_random_integer(1, cfg_P))));
+                }
+            } else {
+                for (size_t c = 0; c < changes; c++) {
+                    const size_t j = sum_of_powers::get_random_integer(0, cfg_L - 1);
+                    t[j] = SymEngine::pow(bases[j], SymEngine::integer(sum_of_powers::get_random_integer(1, cfg_P)));
+                }
+            }
+            for (const auto &term: t) {
+                builder.add_term(term);
+            }
+            auto state = builder.build();
+            hashes.push_back(state->hash());
+            {
+                timer_scope ts(statsPlain);
+                plain.Stream(retId, i, state);
+            }
+            {
+                timer_scope ts(statsDelta);
+                ids.emplace_back(retId, delta.Append(retId, state));
+            }
+        }
+    }
+
+    auto verify = [&](size_t i, const rcp_basic &state) {
+        if (state->hash() != hashes[i]) {
+            std::cout << "Mismatch in serialization at index " << i << std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+    };
+    std::vector<size_t> randomOrder;
+    for (size_t k = 0; k < cfg_N; k++) {
+        randomOrder.push_back(sum_of_powers::get_random_integer(0, cfg_N - 1));
+    }
+
+    for (const std::string order : {"sequential", "random"}) {
+        auto phase = Phase("read_" + order);
+        for (const std::string mode : {"plain", "delta"}) {
+            std::cout << "Reading " << cfg_N << " states, " << order << ", " << mode << std::endl;
+            timer_stats stats("bench18 read " + order + " " + mode, params);
+            timer_scope ts(stats);
+            for (size_t k = 0; k < cfg_N; k++) {
+                const size_t i = order == "sequential" ? k : randomOrder[k];
+                const auto &[retId, index] = ids[i];
+                verify(i, mode == "plain" ? std::get<1>(plain.Read(retId, index)) : delta.Read(retId, index));
+            }
+        }
+    }
+
+    const auto st = delta.GetDeltaStats();
+    const size_t plainSize = plain.GetFileSize(), deltaSize = delta.GetFileSize();
+    std::cout << "File size: plain " << plainSize << " bytes, delta " << deltaSize << " bytes (" <<
+        (deltaSize == 0 ? 0.0 : static_cast<double>(plainSize) / static_cast<double>(deltaSize)) << "x smaller)" <<
+        std::endl;
+    std::cout << "Keyframes: " << st.keyframes << ", deltas: " << st.deltas << ", dict entries written: " <<
+        st.deltaEntries << " in deltas vs " << st.fullEntries << " in full" << std::endl;
+    std::cout << "Read amplification: " << st.ReadAmplification() << " records per read on average, " <<
+        st.maxRecordsPerRead << " in the worst case" << std::endl;
+    plain.Nuke();
+    delta.Nuke();
+}
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench18/bench18.h"
+
+int main() {
+    bench18 b(1024, 1024, 5, 16);
+    b.Run();
+
+    return 0;
+}
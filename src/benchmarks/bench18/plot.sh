@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench18 --file mem_usage_bench18.txt | tee /dev/tty
@@ -0,0 +1,92 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench19.h"
+#include "bench05/CSpillManager.h"
+
+void bench19::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * Generates N exprs of form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * behind the handles of a CSpillManager attached to the soft limit of the global memory tracker, set M MiB above the
+ * RSS at the start of the workload. The exprs that do not fit are spilled to disk while they are generated (on this
+ * thread, when the sampler flags the pressure, unless SymEngine is thread-safe), then all of them are swept in order
+ * (every spilled expr is reloaded, pushing the coldest ones out), then the last N/8 of them are accessed repeatedly
+ * (they stay resident).
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *  - M: Headroom of the soft limit in MiB.
+ */
+void bench19::Workload() {
+    constexpr size_t HOT_ROUNDS = 8;
+    const std::map<std::string, int> params = {
+        {"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"M", (int)cfg_M}
+    };
+    const double softLimit = mem_usage_tracker::getResidentUsage() + static_cast<double>(cfg_M) / 1024.0;
+    std::cout << "Soft limit on the RSS: " << softLimit << " GB" << std::endl;
+
+    CSpillManager spill(storage_dir, "bench19");
+    spill.Attach(mem_tracker, softLimit);
+    std::vector<CSpillManager::Handle> handles;
+    std::vector<SymEngine::hash_t> hashes;
+
+    auto access = [&](size_t i) {
+        if (handles[i].Get()->hash() != hashes[i]) {
+            std::cout << "Mismatch in serialization at index " << i << std::endl;
+            throw std::runtime_error("Serialization mismatch");
+        }
+    };
+
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    {
+        auto phase = Phase("gen");
+        timer_stats stats("bench19 gen", params);
+        timer_scope ts(stats);
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            auto expr = gen.generate(builder);
+            hashes.push_back(expr->hash());
+            handles.push_back(spill.Track(std::move(expr)));
+        }
+    }
+    spill.ReportPhase("gen");
+
+    std::cout << "Sweeping the exprs in order" << std::endl;
+    {
+        auto phase = Phase("sweep");
+        timer_stats stats("bench19 sweep", params);
+        timer_scope ts(stats);
+        for (size_t i = 0; i < cfg_N; i++) {
+            access(i);
+        }
+    }
+    spill.ReportPhase("sweep");
+
+    std::cout << "Accessing the last " << cfg_N / 8 << " exprs " << HOT_ROUNDS << " times" << std::endl;
+    {
+        auto phase = Phase("hot");
+        timer_stats stats("bench19 hot", params);
+        timer_scope ts(stats);
+        for (size_t r = 0; r < HOT_ROUNDS; r++) {
+            for (size_t i = cfg_N - cfg_N / 8; i < cfg_N; i++) {
+                access(i);
+            }
+        }
+    }
+    spill.ReportPhase("hot");
+
+    const auto st = spill.GetTotalStats();
+    std::cout << "Total: " << st.spills << " spills (" << st.spillWrites << " written), " << st.reloads <<
+        " reloads, " << st.pressureEvents << " pressure events" << std::endl;
+    std::cout << "Spill file size: " << spill.GetFileSize() << " bytes, " << spill.GetResidentCount() << " of " <<
+        cfg_N << " exprs resident" << std::endl;
+    spill.Detach();
+    handles.clear();
+}
@@ -0,0 +1,28 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+class bench19: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P, cfg_M;
+    const std::string storage_dir;
+    sum_of_powers gen;
+public:
+    /**
+     * @param cfg_M The headroom in MiB above the RSS at the start of the workload, where the soft limit is set.
+     */
+    bench19(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_M = 256, const std::string& storage_dir = "./") :
+        benchmark_base("bench19"),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_M(cfg_M), storage_dir(storage_dir), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench19/bench19.h"
+
+int main() {
+    bench19 b(1024, 1024*2, 5, 256);
+    b.Run();
+
+    return 0;
+}
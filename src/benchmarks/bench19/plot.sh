@@ -0,0 +1,3 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench19 --file mem_usage_bench19.txt | tee /dev/tty
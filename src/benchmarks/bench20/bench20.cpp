@@ -0,0 +1,233 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "bench20.h"
+#include <functional>
+#include <iomanip>
+#include "symengine/add.h"
+#include "symengine/pow.h"
+#include "utils/visitor_sym.h"
+#include "bench05/CClonedExprReconstruction.h"
+
+void bench20::Preparation() {
+    gen.make_symbols();
+}
+
+/**
+ * Measures what the reference counts of `RCP<const Basic>` cost, on the SymEngine it is built against (atomic or plain
+ * counts, see BENCH20_REFCOUNT). The exprs are of the form:
+ *  expr_i = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ *
+ * Micro cases, R rounds each, over the 2*N*L distinct terms and bases of the exprs (or over the N exprs):
+ *  - copy_transfer / move_transfer: push_back() every RCP of a vector into another one by copy or by std::move().
+ *    The copy costs one increment and one decrement per RCP, the move none: the difference is a refcount round trip.
+ *  - iterate_value / iterate_ref: `for (auto x : v)` vs `for (const auto &x : v)`.
+ *  - get_args / dict_copy / get_dict_ref: the terms of every Add through get_args() (a fresh vec_basic), through a copy
+ *    of get_dict() (as CClonedExprReconstruction does) and through get_dict() by reference.
+ *
+ * Macro phases, on the code of this repo:
+ *  - construct: the N exprs are generated through add_builder, one sample per expr.
+ *  - visitor_sym: visitor_sym::apply() on all the exprs, one sample per round.
+ *  - reconstruct: CClonedExprReconstruction::Apply() on every expr, with a fresh reconstructor per round.
+ *  - dumps / loads: Basic::dumps() and Basic::loads() of every expr.
+ *
+ * The atomic overhead is the ratio of the timers of the two builds (see compare_refcount.py); the avoidable copies are
+ * the differences between the paired micro cases, printed at the end of the run.
+ *
+ *  So our parameters are:
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Power of each term.
+ *  - R: Number of rounds.
+ */
+void bench20::Workload() {
+    const std::map<std::string, int> params = {{"N", (int)cfg_N}, {"L", (int)cfg_L}, {"P", (int)cfg_P}, {"R", (int)cfg_R}};
+    const std::string tag = "bench20 " BENCH20_REFCOUNT " ";
+    std::cout << "Reference counts: " BENCH20_REFCOUNT << std::endl;
+#ifndef WITH_SYMENGINE_RCP
+    std::cout << "SymEngine is built with the Teuchos RCP, the results do not match the matrix" << std::endl;
+#endif
+
+    std::cout << "Generating " << cfg_N << " expressions of length " << cfg_L << " and power " << cfg_P << std::endl;
+    {
+        auto phase = Phase("construct");
+        timer_stats stats(tag + "construct", params);
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            timer_scope ts(stats);
+            exprs.push_back(gen.generate(builder));
+        }
+    }
+
+    SymEngine::vec_basic nodes;
+    for (const auto &e : exprs) {
+        if (!SymEngine::is_a<SymEngine::Add>(*e)) {
+            throw std::runtime_error("The micro cases need exprs of at least two terms");
+        }
+        for (const auto &kv : SymEngine::down_cast<const SymEngine::Add &>(*e).get_dict()) {
+            nodes.push_back(kv.first);
+            if (SymEngine::is_a<SymEngine::Pow>(*kv.first)) {
+                nodes.push_back(SymEngine::down_cast<const SymEngine::Pow &>(*kv.first).get_base());
+            }
+        }
+    }
+    const size_t terms = nodes.size() / 2;
+
+    // The checksum of the micro cases, printed so that none of them can be optimized away.
+    SymEngine::hash_t sink = 0;
+    // The median of every micro case, in ns per RCP.
+    std::map<std::string, double> perRcp;
+    auto micro = [&](const std::string &name, size_t count, const std::function<void()> &body) {
+        timer_stats stats(tag + "micro " + name, params);
+        for (size_t r = 0; r < cfg_R; r++) {
+            timer_scope ts(stats);
+            body();
+        }
+        stats.flush_threads();
+        perRcp[name] = static_cast<double>(stats.median()) * 1e6 / static_cast<double>(count);
+    };
+
+    std::cout << "Micro cases over " << nodes.size() << " RCPs" << std::endl;
+    {
+        auto phase = Phase("micro");
+        SymEngine::vec_basic from = nodes, to;
+        from.reserve(nodes.size());
+        to.reserve(nodes.size());
+        micro("copy_transfer", nodes.size(), [&]() {
+            for (const auto &x : from) {
+                to.push_back(x);
+            }
+            from.clear();
+            std::swap(from, to);
+        });
+        micro("move_transfer", nodes.size(), [&]() {
+            for (auto &x : from) {
+                to.push_back(std::move(x));
+            }
+            from.clear();
+            std::swap(from, to);
+        });
+        from.clear();
+
+        micro("iterate_value", nodes.size(), [&]() {
+            for (auto x : nodes) {
+                sink ^= x->hash();
+            }
+        });
+        micro("iterate_ref", nodes.size(), [&]() {
+            for (const auto &x : nodes) {
+                sink ^= x->hash();
+            }
+        });
+
+        micro("get_args", terms, [&]() {
+            for (const auto &e : exprs) {
+                for (const auto &a : e->get_args()) {
+                    sink ^= a->hash();
+                }
+            }
+        });
+        micro("dict_copy", terms, [&]() {
+            for (const auto &e : exprs) {
+                SymEngine::umap_basic_num dict = SymEngine::down_cast<const SymEngine::Add &>(*e).get_dict();
+                for (const auto &kv : dict) {
+                    sink ^= kv.first->hash();
+                }
+            }
+        });
+        micro("get_dict_ref", terms, [&]() {
+            for (const auto &e : exprs) {
+                for (const auto &kv : SymEngine::down_cast<const SymEngine::Add &>(*e).get_dict()) {
+                    sink ^= kv.first->hash();
+                }
+            }
+        });
+    }
+    nodes.clear();
+
+    std::cout << "Running visitor_sym on all the exprs" << std::endl;
+    {
+        auto phase = Phase("visitor_sym");
+        timer_stats stats(tag + "visitor_sym", params);
+        for (size_t r = 0; r < cfg_R; r++) {
+            timer_scope ts(stats);
+            visitor_sym visitor;
+            if (visitor.apply(exprs) != 0) {
+                throw std::runtime_error("Duplicate symbols found");
+            }
+        }
+    }
+
+    std::cout << "Reconstructing the exprs through CClonedExprReconstruction" << std::endl;
+    {
+        auto phase = Phase("reconstruct");
+        timer_stats stats(tag + "reconstruct", params);
+        for (size_t r = 0; r < cfg_R; r++) {
+            SPruner::ExprSe::CClonedExprReconstruction reconstruction;
+            for (size_t i = 0; i < cfg_N; i++) {
+                SymEngine::RCP<const SymEngine::Basic> rebuilt;
+                {
+                    timer_scope ts(stats);
+                    rebuilt = reconstruction.Apply(*exprs[i], [&](const std::string &name) {
+                        const size_t id = std::stoul(name);
+                        return gen.sym(id / cfg_L, id % cfg_L);
+                    });
+                }
+                if (r == 0 && rebuilt->hash() != exprs[i]->hash()) {
+                    std::cout << "Mismatch in the reconstruction at index " << i << std::endl;
+                    throw std::runtime_error("Reconstruction mismatch");
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> blobs(cfg_N);
+    std::cout << "Serializing the exprs" << std::endl;
+    {
+        auto phase = Phase("dumps");
+        timer_stats stats(tag + "dumps", params);
+        for (size_t r = 0; r < cfg_R; r++) {
+            for (size_t i = 0; i < cfg_N; i++) {
+                timer_scope ts(stats);
+                blobs[i] = exprs[i]->dumps();
+            }
+        }
+    }
+
+    std::cout << "Deserializing the exprs" << std::endl;
+    {
+        auto phase = Phase("loads");
+        timer_stats stats(tag + "loads", params);
+        for (size_t r = 0; r < cfg_R; r++) {
+            for (size_t i = 0; i < cfg_N; i++) {
+                SymEngine::RCP<const SymEngine::Basic> loaded;
+                {
+                    timer_scope ts(stats);
+                    loaded = SymEngine::Basic::loads(blobs[i]);
+                }
+                if (r == 0 && loaded->hash() != exprs[i]->hash()) {
+                    std::cout << "Mismatch in serialization at index " << i << std::endl;
+                    throw std::runtime_error("Serialization mismatch");
+                }
+            }
+        }
+    }
+
+    std::cout << "Checksum: " << sink << std::endl;
+    std::cout << "Micro cases (" BENCH20_REFCOUNT " reference counts), median ns per RCP:" << std::endl;
+    for (const auto &[name, ns] : perRcp) {
+        std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2) <<
+            std::setw(10) << ns << std::endl;
+    }
+    auto saving = [&](const std::string &slow, const std::string &fast, const std::string &what) {
+        std::cout << "  " << what << ": " << std::fixed << std::setprecision(2) << perRcp[slow] - perRcp[fast] <<
+            " ns per RCP (" << slow << " vs " << fast << ")" << std::endl;
+    };
+    std::cout << "Avoidable per RCP:" << std::endl;
+    saving("copy_transfer", "move_transfer", "refcount increment + decrement, by moving instead of copying");
+    saving("iterate_value", "iterate_ref", "by iterating by reference");
+    saving("get_args", "get_dict_ref", "by reading get_dict() instead of get_args()");
+    saving("dict_copy", "get_dict_ref", "by binding get_dict() to a reference instead of copying it");
+    exprs.clear();
+}
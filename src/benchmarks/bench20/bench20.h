@@ -0,0 +1,38 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include "benchmark_base.h"
+#include "sum_of_powers.h"
+#include "symengine/basic.h"
+
+/**
+ * The flavor of the reference counts of the SymEngine this benchmark is built against, which tags its timers and its
+ * memory trace: atomic with `WITH_SYMENGINE_THREAD_SAFE=ON`, plain otherwise.
+ */
+#ifdef WITH_SYMENGINE_THREAD_SAFE
+#define BENCH20_REFCOUNT "atomic"
+#else
+#define BENCH20_REFCOUNT "plain"
+#endif
+
+class bench20: public benchmark_base {
+protected:
+    const size_t cfg_N, cfg_L, cfg_P, cfg_R;
+    sum_of_powers gen;
+    SymEngine::vec_basic exprs;
+public:
+    /**
+     * @param cfg_R The number of rounds of every micro case and of every macro phase but the construction.
+     */
+    bench20(size_t cfg_N, size_t cfg_L, size_t cfg_P, size_t cfg_R = 16) :
+        benchmark_base("bench20_" BENCH20_REFCOUNT),
+        cfg_N(cfg_N), cfg_L(cfg_L), cfg_P(cfg_P), cfg_R(cfg_R), gen(cfg_L, cfg_P, true)
+    {}
+
+    void Preparation() override;
+
+    void Workload() override;
+};
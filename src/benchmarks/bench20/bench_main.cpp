@@ -0,0 +1,13 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <iostream>
+#include "bench20/bench20.h"
+
+int main() {
+    bench20 b(256, 64, 5, 16);
+    b.Run();
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+import argparse
+import glob
+import json
+import os
+
+# The stats of bench20 are saved by timer_stats as stats_bench20_<flavor>_<timer>.<pairs>.json, where every run of the
+# same configuration appends one more JSON object to the file; the last one is used.
+
+FLAVORS = ("atomic", "plain")
+
+
+def read_last(file):
+    decoder = json.JSONDecoder()
+    with open(file, 'r') as f:
+        text = f.read()
+    last, pos = None, 0
+    while True:
+        while pos < len(text) and text[pos].isspace():
+            pos += 1
+        if pos >= len(text):
+            return last
+        try:
+            last, pos = decoder.raw_decode(text, pos)
+        except json.JSONDecodeError as e:
+            print(f"Error parsing {file}: {e}")
+            return last
+
+
+def read_flavor(directory, flavor):
+    # (timer, pairs) -> median in ms
+    medians = {}
+    prefix = f"bench20 {flavor} "
+    for file in glob.glob(os.path.join(directory, f"stats_bench20_{flavor}_*.json")):
+        stats = read_last(file)
+        if stats is None or not stats["name"].startswith(prefix):
+            continue
+        key = (stats["name"][len(prefix):], json.dumps(stats["pairs"], sort_keys=True))
+        medians[key] = stats["median"]
+    return medians
+
+
+def compare(directory):
+    atomic, plain = (read_flavor(directory, flavor) for flavor in FLAVORS)
+    keys = sorted(set(atomic) & set(plain))
+    if not keys:
+        print(f"No timer of bench20 was found for both flavors in {directory}")
+        return
+    print(f"{'timer':<28} {'pairs':<40} {'atomic (ms)':>12} {'plain (ms)':>12} {'overhead':>10}")
+    for timer, pairs in keys:
+        a, p = atomic[(timer, pairs)], plain[(timer, pairs)]
+        overhead = f"{(a / p - 1) * 100:+.1f}%" if p > 0 else "n/a"
+        print(f"{timer:<28} {pairs:<40} {a:>12.4f} {p:>12.4f} {overhead:>10}")
+    for flavor, missing in (("atomic", set(plain) - set(atomic)), ("plain", set(atomic) - set(plain))):
+        for timer, pairs in sorted(missing):
+            print(f"No {flavor} run of {timer} with {pairs}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Compare the timers of bench20 built with atomic and with plain '
+                                                 'reference counts.')
+    parser.add_argument('--dir', type=str, default='.', help='Directory of the stats_bench20_*.json files')
+    args = parser.parse_args()
+    compare(args.dir)
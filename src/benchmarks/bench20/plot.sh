@@ -0,0 +1,6 @@
+#!/bin/bash
+
+python ../plot_mem_usage.py --title bench20 --file mem_usage_bench20_atomic.txt --file mem_usage_bench20_plain.txt | tee /dev/tty
+
+# The overhead of the atomic reference counts, once both bench20_atomic_main and bench20_plain_main have run here
+python compare_refcount.py --dir . | tee /dev/tty
@@ -0,0 +1,74 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark_base.h"
+
+/**
+ * The knobs shared by the sum-of-powers benchmarks.
+ *  - N: Number of exprs.
+ *  - L: Number of terms in each expr.
+ *  - P: Max power of each term.
+ *  - workDir: Where the benchmark is allowed to put its scratch files (with a trailing slash).
+ */
+struct bench_params {
+    size_t N = 0;
+    size_t L = 0;
+    size_t P = 0;
+    std::string workDir = "./";
+};
+
+/**
+ * A name -> factory map of the `benchmark_base` subclasses that `bench_runner` can run.
+ */
+class bench_registry {
+public:
+    using factory = std::function<std::unique_ptr<benchmark_base>(const bench_params&)>;
+
+    struct entry {
+        factory create;
+        bench_params defaults;
+        std::string description;
+    };
+
+private:
+    std::map<std::string, entry> m_mEntries;
+
+public:
+    static bench_registry& instance() {
+        static bench_registry s_oInstance;
+        return s_oInstance;
+    }
+
+    void add(const std::string& name, const std::string& description, const bench_params& defaults, factory create) {
+        if (m_mEntries.count(name) != 0) {
+            throw std::runtime_error("Benchmark " + name + " is registered twice");
+        }
+        m_mEntries[name] = {std::move(create), defaults, description};
+    }
+
+    const entry& get(const std::string& name) const {
+        auto it = m_mEntries.find(name);
+        if (it == m_mEntries.end()) {
+            throw std::runtime_error("Unknown benchmark: " + name);
+        }
+        return it->second;
+    }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (auto &[k, v] : m_mEntries) {
+            result.push_back(k);
+        }
+        return result;
+    }
+};
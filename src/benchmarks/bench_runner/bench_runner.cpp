@@ -0,0 +1,351 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "json/json.h"
+#include <boost/filesystem.hpp>
+
+#include "bench_registry.h"
+#include "bench01/bench01.h"
+#include "bench02/bench02.h"
+#include "bench03/bench03.h"
+#include "bench04/bench04.h"
+#include "bench05/bench05.h"
+#include "bench06/bench06.h"
+#include "bench07/bench07.h"
+#include "bench08/bench08.h"
+#include "bench09/bench09.h"
+#include "bench10/bench10.h"
+#include "bench11/bench11.h"
+#include "bench12/bench12.h"
+#include "bench13/bench13.h"
+#include "bench14/bench14.h"
+#include "bench15/bench15.h"
+#include "bench16/bench16.h"
+#include "bench17/bench17.h"
+#include "bench18/bench18.h"
+#include "bench19/bench19.h"
+#include "bench20/bench20.h"
+
+/**
+ * Every benchmark that bench_runner can sweep has to be listed here.
+ */
+static void register_benchmarks() {
+    auto &r = bench_registry::instance();
+    r.add("bench01", "Sum of powers, per-expr dumps()/loads() through loose files", {16, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench01>(p.N, p.L, p.P); });
+    r.add("bench02", "Sum of powers, per-expr dumps()/loads() vs one vec_basic archive", {16, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench02>(p.N, p.L, p.P); });
+    r.add("bench03", "bench02 suite on expanded exprs", {4, 64, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench03>(p.N, p.L, p.P); });
+    r.add("bench04", "bench02 suite on wide vs deep exprs", {16, 1024, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench04>(p.N, p.L, p.P); });
+    r.add("bench05", "Sum of powers, RetID storage through CFileWriterBase", {1024, 4096, 15, "./"},
+          [](const bench_params& p) { return std::make_unique<bench05>(p.N, p.L, p.P, p.workDir); });
+    r.add("bench06", "Repeated add vs add(vec_basic) vs add_builder for L = 1K..L", {4, 1024 * 64, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench06>(p.N, p.L, p.P); });
+    r.add("bench07", "bench01 workload with and without the hash_cons unique table, N = 16..N", {1024, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench07>(p.N, p.L, p.P); });
+    r.add("bench08_stream", "Generate-and-stream through CFileWriter", {1024, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench08>(p.N, p.L, p.P, bench08::mode::STREAM, p.workDir); });
+    r.add("bench08_materialize", "Generate all, then save through CFileWriterBase", {1024, 1024 * 2, 5, "./"},
+          [](const bench_params& p) {
+              return std::make_unique<bench08>(p.N, p.L, p.P, bench08::mode::MATERIALIZE, p.workDir);
+          });
+    r.add("bench09", "Query-style workload, eager loads() vs lazy_sum", {1024, 1024 * 4, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench09>(p.N, p.L, p.P); });
+    r.add("bench10", "Expanded sums of powers, dumps()/loads() vs sparse polynomial format", {4, 64, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench10>(p.N, p.L, p.P); });
+    r.add("bench11", "Serial expand() vs parallel_expand() for L = 64..L and P = 5..P", {4, 4096, 15, "./"},
+          [](const bench_params& p) { return std::make_unique<bench11>(p.N, p.L, p.P); });
+    r.add("bench12", "Symbol names as strings vs varint ids of a symbol table", {64, 1024 * 64, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench12>(p.N, p.L, p.P); });
+    r.add("bench13", "Read(retId, i) loop vs read-ahead Scan(), cold and warm page cache", {1024, 1024 * 4, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench13>(p.N, p.L, p.P, p.workDir); });
+    r.add("bench14", "CFileWriter appends of repeated states with and without dedup", {1024, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench14>(p.N, p.L, p.P, 4, p.workDir); });
+    r.add("bench15", "Erase/Truncate of short-lived retIds and online compaction", {1024, 1024, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench15>(p.N, p.L, p.P, 8, p.workDir); });
+    r.add("bench16", "Appends from T = 1..hardware threads, single file vs sharded writers", {1024, 1024, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench16>(p.N, p.L, p.P, 0, p.workDir); });
+    r.add("bench17", "Batch of scattered pairs, Read() loop vs ReadMany(), cold and warm page cache", {4096, 256, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench17>(p.N, p.L, p.P, 2048, p.workDir); });
+    r.add("bench18", "Successive states per retId, full records vs delta-encoded records", {1024, 1024, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench18>(p.N, p.L, p.P, 16, p.workDir); });
+    r.add("bench19", "Exprs behind handles of a spill manager under a soft RSS limit", {1024, 1024 * 2, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench19>(p.N, p.L, p.P, 256, p.workDir); });
+    r.add("bench20", "RCP copies vs moves and macro phases, per refcount flavor of SymEngine", {256, 64, 5, "./"},
+          [](const bench_params& p) { return std::make_unique<bench20>(p.N, p.L, p.P, 16); });
+}
+
+struct sweep {
+    std::string bench;
+    std::vector<size_t> N, L, P;
+};
+
+struct runner_config {
+    std::string outDir = "bench_results";
+    size_t warmups = 0;
+    size_t reps = 1;
+    std::vector<sweep> sweeps;
+};
+
+/**
+ * Parses a value list of a sweep:
+ *  - "16,32,64"       : explicit values
+ *  - "1024:65536:x2"  : geometric range, both ends included
+ *  - "1:15:+2"        : linear range, both ends included
+ */
+static std::vector<size_t> parse_values(const std::string& spec) {
+    std::vector<size_t> result;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto c1 = item.find(':');
+        if (c1 == std::string::npos) {
+            result.push_back(std::stoull(item));
+            continue;
+        }
+        auto c2 = item.find(':', c1 + 1);
+        if (c2 == std::string::npos || c2 + 2 > item.size()) {
+            throw std::runtime_error("Invalid range: " + item);
+        }
+        const size_t first = std::stoull(item.substr(0, c1));
+        const size_t last = std::stoull(item.substr(c1 + 1, c2 - c1 - 1));
+        const char op = item[c2 + 1];
+        const size_t step = std::stoull(item.substr(c2 + 2));
+        if ((op == 'x' && step < 2) || (op == '+' && step < 1) || (op != 'x' && op != '+')) {
+            throw std::runtime_error("Invalid range step: " + item);
+        }
+        for (size_t v = first; v <= last; v = (op == 'x' ? v * step : v + step)) {
+            result.push_back(v);
+            if (v == 0 && op == 'x') {
+                break;
+            }
+        }
+    }
+    if (result.empty()) {
+        throw std::runtime_error("Empty value list: " + spec);
+    }
+    return result;
+}
+
+static std::vector<size_t> parse_json_values(const Json::Value& v, const std::vector<size_t>& fallback) {
+    if (v.isNull()) {
+        return fallback;
+    }
+    if (v.isString()) {
+        return parse_values(v.asString());
+    }
+    if (v.isArray()) {
+        std::vector<size_t> result;
+        for (const auto &e : v) {
+            result.push_back(e.asUInt64());
+        }
+        return result;
+    }
+    return {static_cast<size_t>(v.asUInt64())};
+}
+
+/**
+ * {
+ *   "out": "results", "warmup": 1, "reps": 3,
+ *   "sweeps": [ {"bench": "bench01", "N": "16,32", "L": "1024:65536:x2", "P": [5]} ]
+ * }
+ * Missing N/L/P fall back to the defaults of the benchmark.
+ */
+static void load_config_file(const std::string& path, runner_config& cfg) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open the config file " + path);
+    }
+    Json::Value root;
+    file >> root;
+    cfg.outDir = root.get("out", cfg.outDir).asString();
+    cfg.warmups = root.get("warmup", static_cast<Json::UInt64>(cfg.warmups)).asUInt64();
+    cfg.reps = root.get("reps", static_cast<Json::UInt64>(cfg.reps)).asUInt64();
+    for (const auto &s : root["sweeps"]) {
+        sweep sw;
+        sw.bench = s["bench"].asString();
+        const auto &defaults = bench_registry::instance().get(sw.bench).defaults;
+        sw.N = parse_json_values(s["N"], {defaults.N});
+        sw.L = parse_json_values(s["L"], {defaults.L});
+        sw.P = parse_json_values(s["P"], {defaults.P});
+        cfg.sweeps.push_back(sw);
+    }
+}
+
+static void print_usage() {
+    std::cout << "Usage: bench_runner [--config sweep.json] [--bench NAME]... [--N LIST] [--L LIST] [--P LIST]\n"
+                 "                    [--warmup K] [--reps K] [--out DIR] [--list]\n"
+                 "LIST is a comma separated list of values, first:last:xFACTOR or first:last:+STEP.\n"
+                 "Every point runs in a fresh subprocess inside DIR/<bench>/N<n>_L<l>_P<p>/<rep>/ and the\n"
+                 "wall time and peak RSS of each run are collected into DIR/results.csv." << std::endl;
+    std::cout << "Registered benchmarks:" << std::endl;
+    for (auto &name : bench_registry::instance().names()) {
+        std::cout << "  " << name << ": " << bench_registry::instance().get(name).description << std::endl;
+    }
+}
+
+/**
+ * Runs one repetition of one point in a child process, so that every run starts from a clean heap and the peak RSS
+ * reported by wait4() belongs to that run only.
+ * @return The exit status of the child, or -1 if it did not exit normally.
+ */
+static int run_point(const std::string& bench, const bench_params& params, const std::string& runDir,
+                     double& wallMs, long& maxRssKb) {
+    boost::filesystem::create_directories(runDir);
+    std::cout.flush();
+    std::cerr.flush();
+
+    const auto t1 = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork() failed");
+    }
+    if (pid == 0) {
+        int status = 0;
+        try {
+            if (chdir(runDir.c_str()) != 0) {
+                throw std::runtime_error("Cannot chdir into " + runDir);
+            }
+            if (!std::freopen("stdout.txt", "w", stdout) || !std::freopen("stderr.txt", "w", stderr)) {
+                throw std::runtime_error("Cannot redirect the output of the run");
+            }
+            auto b = bench_registry::instance().get(bench).create(params);
+            b->Run();
+        } catch (const std::exception& e) {
+            std::cerr << "Run failed: " << e.what() << std::endl;
+            status = 1;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        std::exit(status);
+    }
+
+    int status = 0;
+    struct rusage ru{};
+    if (wait4(pid, &status, 0, &ru) < 0) {
+        throw std::runtime_error("wait4() failed");
+    }
+    wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+    maxRssKb = ru.ru_maxrss;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char** argv) {
+    register_benchmarks();
+
+    runner_config cfg;
+    sweep cli;
+    std::vector<std::string> cliBenches;
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--config") {
+                load_config_file(next(), cfg);
+            } else if (arg == "--bench") {
+                cliBenches.push_back(next());
+            } else if (arg == "--N") {
+                cli.N = parse_values(next());
+            } else if (arg == "--L") {
+                cli.L = parse_values(next());
+            } else if (arg == "--P") {
+                cli.P = parse_values(next());
+            } else if (arg == "--warmup") {
+                cfg.warmups = std::stoull(next());
+            } else if (arg == "--reps") {
+                cfg.reps = std::stoull(next());
+            } else if (arg == "--out") {
+                cfg.outDir = next();
+            } else if (arg == "--list" || arg == "--help" || arg == "-h") {
+                print_usage();
+                return 0;
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        for (auto &name : cliBenches) {
+            const auto &defaults = bench_registry::instance().get(name).defaults;
+            sweep sw = cli;
+            sw.bench = name;
+            if (sw.N.empty()) sw.N = {defaults.N};
+            if (sw.L.empty()) sw.L = {defaults.L};
+            if (sw.P.empty()) sw.P = {defaults.P};
+            cfg.sweeps.push_back(sw);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        print_usage();
+        return 2;
+    }
+
+    if (cfg.sweeps.empty()) {
+        print_usage();
+        return 2;
+    }
+
+    const auto outDir = boost::filesystem::absolute(cfg.outDir).string();
+    boost::filesystem::create_directories(outDir);
+    const auto csvPath = outDir + "/results.csv";
+    const bool csvExists = boost::filesystem::exists(csvPath);
+    std::ofstream csv(csvPath, std::ios::app);
+    if (!csvExists) {
+        csv << "bench,N,L,P,kind,rep,exit_status,wall_ms,max_rss_kb,dir" << std::endl;
+    }
+
+    size_t failures = 0;
+    for (auto &sw : cfg.sweeps) {
+        for (auto n : sw.N) {
+            for (auto l : sw.L) {
+                for (auto p : sw.P) {
+                    const auto pointDir = outDir + "/" + sw.bench + "/N" + std::to_string(n) + "_L" +
+                        std::to_string(l) + "_P" + std::to_string(p);
+                    for (size_t r = 0; r < cfg.warmups + cfg.reps; r++) {
+                        const bool warmup = r < cfg.warmups;
+                        const size_t idx = warmup ? r : r - cfg.warmups;
+                        const auto runDir = pointDir + "/" + (warmup ? "warmup" : "rep") + std::to_string(idx) + "/";
+                        bench_params params{n, l, p, runDir};
+
+                        std::cout << "*** " << sw.bench << " N=" << n << " L=" << l << " P=" << p << " " <<
+                            (warmup ? "warmup " : "rep ") << idx << std::endl;
+                        double wallMs = 0;
+                        long maxRssKb = 0;
+                        const int status = run_point(sw.bench, params, runDir, wallMs, maxRssKb);
+                        if (status != 0) {
+                            failures++;
+                            std::cerr << "    |___> failed with status " << status << ", see " << runDir << std::endl;
+                        } else {
+                            std::cout << "    |___> " << wallMs << " ms, peak RSS " << maxRssKb << " KB" << std::endl;
+                        }
+                        csv << sw.bench << "," << n << "," << l << "," << p << "," << (warmup ? "warmup" : "rep") <<
+                            "," << idx << "," << status << "," << wallMs << "," << maxRssKb << "," << runDir <<
+                            std::endl;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << "Results are collected in " << csvPath << std::endl;
+    return failures == 0 ? 0 : 1;
+}
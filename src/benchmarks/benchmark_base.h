@@ -5,36 +5,97 @@
 #pragma once
 
 #include <iostream>
+#include <cstdlib>
+#include <memory>
 #include "utils/timers.h"
 #include "utils/mem_usage_tracker.h"
+#include "utils/phase_profiler.h"
+#include "utils/perf_counters.h"
 
 #define SAMPLING_INTERVAL_MS 100
 
 class benchmark_base {
 protected:
     const std::string name;
-    mem_usage_tracker mem_tracker;
+    mem_usage_tracker& mem_tracker;
 
+    /**
+     * A phase of the workload: a nested scope in the trace and a span of the memory trace of the benchmark, between
+     * the begin and end markers it pushes into the shared sampler.
+     * Setting the environment variable `BENCH_PERF_COUNTERS=1` also captures the hardware counters of the phase.
+     */
+    class phase_guard {
+    private:
+        const std::string m_sPhase;
+        phase_scope m_oScope;
+        std::unique_ptr<perf_scope> m_pPerf;
+
+    public:
+        phase_guard(const std::string& bench, const std::string& phase) :
+            m_sPhase(phase),
+            m_oScope(phase) {
+            mem_usage_tracker::instance().phaseBegin(phase);
+            const char* env = std::getenv("BENCH_PERF_COUNTERS");
+            if (env != nullptr && std::string(env) == "1") {
+                m_pPerf = std::make_unique<perf_scope>(bench + "." + phase);
+            }
+        }
+
+        ~phase_guard() {
+            // The counters stop before the end marker, so that they do not count its sample.
+            m_pPerf.reset();
+            mem_usage_tracker::instance().phaseEnd(m_sPhase);
+        }
+
+        phase_guard(const phase_guard&) = delete;
+
+        phase_guard& operator=(const phase_guard&) = delete;
+
+        /**
+         * The amount of work done in the phase, used to report the hardware counters per unit.
+         */
+        void SetUnits(size_t units, const std::string& unitName = "node") {
+            if (m_pPerf) {
+                m_pPerf->set_units(units, unitName);
+            }
+        }
+    };
+
+    phase_guard Phase(const std::string& phase) const {
+        return phase_guard(name, phase);
+    }
 
 public:
-    virtual ~benchmark_base() = default;
+    virtual ~benchmark_base() {
+        mem_tracker.stop();
+    }
 
     explicit benchmark_base(const std::string& name) :
         name(name),
-        mem_tracker(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".global.txt") {
+        mem_tracker(mem_usage_tracker::instance()) {
+        mem_tracker.start(SAMPLING_INTERVAL_MS, 100, "mem_usage_" + name + ".txt");
+        phase_profiler::instance().enable();
         std::cout << "==============================================" << std::endl;
         std::cout << "*** Benchmark " << name << " created" << std::endl;
     }
 
     void Run() {
         std::cout << "*** Benchmark " << name << " started" << std::endl;
-        Preparation();
-        std::cout << "*** Benchmark " << name << " preparation finished" << std::endl;
         {
-            timer_scope ts("Time (ms) spent in Workload for " + name);
-            Workload();
+            phase_scope ps(name);
+            {
+                phase_scope ps_prep("Preparation");
+                Preparation();
+            }
+            std::cout << "*** Benchmark " << name << " preparation finished" << std::endl;
+            {
+                phase_scope ps_workload("Workload");
+                timer_scope ts("Time (ms) spent in Workload for " + name);
+                Workload();
+            }
         }
         std::cout << "*** Benchmark " << name << " finished" << std::endl;
+        phase_profiler::instance().write_chrome_trace("trace_" + name + ".json");
         //mem_tracker.requestStopAndWait();
     }
 
@@ -2,80 +2,102 @@ import argparse
 import os
 import seaborn as sns
 import matplotlib.pyplot as plt
-import datetime
-import matplotlib.dates as mdates
+
+# The trace of mem_usage_tracker:
+#   S|B|E,t_ms,vm_gb,rss_gb,allocated_gb,in_use_gb,free_gb[,phase]
+#   P,phase,begin_ms,end_ms,rss_begin_gb,rss_end_gb,rss_peak_gb,in_use_peak_gb
+
+def read_trace(file):
+    samples = {"t": [], "vm": [], "rss": [], "allocated": [], "in_use": [], "free": []}
+    spans = []
+    summaries = []
+    open_phases = []
+    with open(file, 'r') as f:
+        for line in f:
+            if line.startswith('#') or not line.strip():
+                continue
+            parts = line.strip().split(',')
+            try:
+                if parts[0] == 'P' and len(parts) == 8:
+                    summaries.append((parts[1],) + tuple(float(x) for x in parts[2:]))
+                    continue
+                if parts[0] not in ('S', 'B', 'E') or len(parts) < 7:
+                    print(f"Skipping invalid line in {file}: {line}")
+                    continue
+                t, vm, rss, allocated, in_use, free = (float(x) for x in parts[1:7])
+            except ValueError as e:
+                print(f"Error parsing line in {file}: {line} -> {e}")
+                continue
+            samples["t"].append(t / 1000.0)
+            samples["vm"].append(vm)
+            samples["rss"].append(rss)
+            samples["allocated"].append(allocated)
+            samples["in_use"].append(in_use)
+            samples["free"].append(free)
+            if parts[0] == 'B':
+                open_phases.append((parts[7], t / 1000.0))
+            elif parts[0] == 'E':
+                for k in range(len(open_phases) - 1, -1, -1):
+                    if open_phases[k][0] == parts[7]:
+                        name, begin = open_phases.pop(k)
+                        spans.append((name, begin, t / 1000.0, len(open_phases)))
+                        break
+    return samples, spans, summaries
+
 
 def plot_mem_usage(files, title):
     # Metrics and their subplot indices
     metrics = [
-        "Memory Usage",
-        "Total Allocated",
-        "Total In Use",
-        "Total Free",
-        #"External Fragmentation"
+        ("rss", "RSS"),
+        ("vm", "Virtual Size"),
+        ("allocated", "Total Allocated"),
+        ("in_use", "Total In Use"),
+        ("free", "Total Free"),
     ]
 
     num_metrics = len(metrics)
-    fig, axes = plt.subplots(num_metrics, 1, figsize=(12, 8), sharex=True)
+    fig, axes = plt.subplots(num_metrics, 1, figsize=(12, 10), sharex=True)
     colors = sns.color_palette("RdYlBu", len(files))  # Use warmer colors
-    markers = ['o', 's', 'D', '^', 'v', '<', '>', 'p', '*', 'h']
+    span_colors = sns.color_palette("pastel", 10)
 
     for idx, file in enumerate(files):
         if not os.path.isfile(file):
             print(f"File {file} does not exist.")
             continue
 
-        dates = []
-        memoryUsageInGB = []
-        totalAllocatedSpace = []
-        totalInUseSpace = []
-        totalFreeSpace = []
-        externalFragmentation = []
-
         print(f"Processing file: {file}")
-
-        with open(file, 'r') as f:
-            for line in f:
-                parts = line.strip().split(',')
-                if len(parts) != 6:
-                    print(f"Skipping invalid line in {file}: {line}")
-                    continue
-                try:
-                    date_time_str, mem_usage, total_alloc, total_in_use, total_free, ext_frag = parts
-                    dates.append(datetime.datetime.strptime(date_time_str, "%Y/%m/%d %H:%M:%S.%f"))
-                    memoryUsageInGB.append(float(mem_usage))
-                    totalAllocatedSpace.append(float(total_alloc))
-                    totalInUseSpace.append(float(total_in_use))
-                    totalFreeSpace.append(float(total_free))
-                    externalFragmentation.append(float(ext_frag))
-                except ValueError as e:
-                    print(f"Error parsing line in {file}: {line} -> {e}")
-                    continue
-
-        if not dates:
+        samples, spans, summaries = read_trace(file)
+        if not samples["t"]:
             print(f"No valid data in file: {file}")
             continue
+        print(f"File {file} processed successfully with {len(samples['t'])} entries.")
+
+        for i, (key, _) in enumerate(metrics):
+            axes[i].plot(samples["t"], samples[key], label=os.path.basename(file), color=colors[idx], marker='.')
 
-        print(f"File {file} processed successfully with {len(dates)} entries.")
+        # The outermost phases of the first trace are shaded on every subplot.
+        if idx == 0:
+            for k, (name, begin, end, depth) in enumerate(s for s in spans if s[3] == 0):
+                for ax in axes:
+                    ax.axvspan(begin, end, color=span_colors[k % len(span_colors)], alpha=0.3)
+                axes[0].text((begin + end) / 2, 1.0, name, transform=axes[0].get_xaxis_transform(), ha="center",
+                             va="bottom", fontsize="small", rotation=30)
 
-        # Plot data on corresponding subplots
-        axes[0].plot(dates, memoryUsageInGB, label=os.path.basename(file), color=colors[idx], marker=markers[0 % len(markers)])
-        axes[1].plot(dates, totalAllocatedSpace, label=os.path.basename(file), color=colors[idx], marker=markers[1 % len(markers)])
-        axes[2].plot(dates, totalInUseSpace, label=os.path.basename(file), color=colors[idx], marker=markers[2 % len(markers)])
-        axes[3].plot(dates, totalFreeSpace, label=os.path.basename(file), color=colors[idx], marker=markers[3 % len(markers)])
-        #axes[4].plot(dates, externalFragmentation, label=os.path.basename(file), color=colors[idx], marker=markers[4 % len(markers)])
+        if summaries:
+            print(f"{'phase':<32} {'duration (s)':>12} {'RSS delta (GB)':>15} {'RSS peak (GB)':>14} "
+                  f"{'in-use peak (GB)':>17}")
+            for name, begin, end, rss_begin, rss_end, rss_peak, in_use_peak in summaries:
+                print(f"{name:<32} {(end - begin) / 1000.0:>12.3f} {rss_end - rss_begin:>15.4f} {rss_peak:>14.4f} "
+                      f"{in_use_peak:>17.4f}")
 
     # Set titles, labels, and legends for subplots
     for i, ax in enumerate(axes):
-        ax.set_title(metrics[i])
+        ax.set_title(metrics[i][1])
         ax.set_ylabel("GB")
         ax.legend(loc="best", fontsize="small")
         ax.grid(True)
 
-    axes[-1].set_xlabel("Date-Time")  # Set xlabel only for the last subplot
-    axes[-1].xaxis.set_major_formatter(mdates.DateFormatter('%Y-%m-%d %H:%M:%S'))  # Include seconds in the format
-    axes[-1].xaxis.set_major_locator(mdates.AutoDateLocator())
-    plt.setp(axes[-1].xaxis.get_majorticklabels(), rotation=45, ha="right")  # Rotate x-ticks for readability
+    axes[-1].set_xlabel("Time (s)")  # Set xlabel only for the last subplot
 
     # Add figure title
     fig.suptitle(title, fontsize=16, fontweight='bold')
@@ -84,8 +106,8 @@ def plot_mem_usage(files, title):
     plt.show()
 
 if __name__ == "__main__":
-    parser = argparse.ArgumentParser(description='Plot memory usage from multiple files.')
-    parser.add_argument('--file', type=str, action='append', required=True, help='List of files to plot')
+    parser = argparse.ArgumentParser(description='Plot the memory traces of mem_usage_tracker, with their phases.')
+    parser.add_argument('--file', type=str, action='append', required=True, help='List of traces to plot')
     parser.add_argument('--title', type=str, default=None, required=True, help='Title for the figure')
     args = parser.parse_args()
     print(f"Files to process: {args.file}")
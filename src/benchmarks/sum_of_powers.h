@@ -0,0 +1,102 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "symengine/basic.h"
+#include "symengine/symbol.h"
+#include "symengine/add.h"
+#include "symengine/pow.h"
+#include "symengine/integer.h"
+#include "utils/expr_builder.h"
+
+/**
+ * The workload shared by the benchmarks of this repo: 3 flat tensors a, b, c of size `cfg_L` and exprs of the form
+ *  expr = Sum_{j=0}^{L} (a_j + b_j + c_j)^get_random_integer(min=1, max=P)
+ * The symbols are created once and are shared by all the generated exprs.
+ */
+class sum_of_powers {
+protected:
+    const size_t cfg_L, cfg_P;
+    const bool numeric_names;
+    SymEngine::vec_basic id_to_sym;
+
+public:
+    /**
+     * @param numeric_names Name the symbols after their id (as bench05 does) instead of a_j, b_j and c_j (as bench01).
+     */
+    sum_of_powers(size_t cfg_L, size_t cfg_P, bool numeric_names = false) :
+        cfg_L(cfg_L), cfg_P(cfg_P), numeric_names(numeric_names) {
+    }
+
+    void make_symbols() {
+        const char* prefixes[] = {"a_", "b_", "c_"};
+        id_to_sym.resize(3 * cfg_L);
+        for (size_t tid = 0; tid < 3; tid++) {
+            for (size_t flat = 0; flat < cfg_L; flat++) {
+                const auto id = get_symbol_id(tid, flat);
+                id_to_sym[id] = SymEngine::symbol(
+                    numeric_names ? std::to_string(id) : prefixes[tid] + std::to_string(flat));
+            }
+        }
+    }
+
+    void clear() {
+        id_to_sym.clear();
+    }
+
+    const SymEngine::RCP<const SymEngine::Basic>& sym(size_t tid, size_t flat_idx) const {
+        return id_to_sym[get_symbol_id(tid, flat_idx)];
+    }
+
+    SymEngine::RCP<const SymEngine::Basic> base(size_t j) const {
+        return SymEngine::add(SymEngine::add(sym(0, j), sym(1, j)), sym(2, j));
+    }
+
+    /**
+     * @return The L terms of one expr, in order, without summing them.
+     */
+    SymEngine::vec_basic terms() const {
+        SymEngine::vec_basic result;
+        result.reserve(cfg_L);
+        for (size_t j = 0; j < cfg_L; j++) {
+            result.push_back(SymEngine::pow(base(j), SymEngine::integer(get_random_integer(1, cfg_P))));
+        }
+        return result;
+    }
+
+    SymEngine::RCP<const SymEngine::Basic> generate(add_builder &builder) const {
+        for (size_t j = 0; j < cfg_L; j++) {
+            builder.add_term(SymEngine::pow(base(j), SymEngine::integer(get_random_integer(1, cfg_P))));
+        }
+        return builder.build();
+    }
+
+    SymEngine::vec_basic generate(size_t cfg_N) const {
+        SymEngine::vec_basic exprs;
+        add_builder builder(cfg_L);
+        for (size_t i = 0; i < cfg_N; i++) {
+            exprs.push_back(generate(builder));
+        }
+        return exprs;
+    }
+
+    /**
+     * Get the unique symbol id for the symbol across all tensors.
+     * @param tid The tensor Id. All tensors are assumed to be of the same size.
+     * @param flat_idx The flat index of the tensor element.
+     * @return The unique symbol id for the symbol across all tensors.
+     */
+    size_t get_symbol_id(size_t tid, size_t flat_idx) const {
+        return tid * cfg_L + flat_idx;
+    }
+
+    static size_t get_random_integer(size_t min, size_t max) {
+        return min + (rand() % static_cast<int>(max - min + 1));
+    }
+};
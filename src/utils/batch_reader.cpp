@@ -0,0 +1,254 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "batch_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+    struct extent {
+        uint64_t offset;
+        std::vector<iovec> iov;
+    };
+
+    /**
+     * Sorts the requests by offset and merges the contiguous ones, at most IOV_MAX per extent.
+     */
+    std::vector<extent> merge(std::vector<batch_reader::request>& requests) {
+        std::sort(requests.begin(), requests.end(), [](const auto& a, const auto& b) {
+            return a.offset < b.offset;
+        });
+        std::vector<extent> extents;
+        uint64_t end = 0;
+        for (const auto& r : requests) {
+            if (r.len == 0) {
+                continue;
+            }
+            if (extents.empty() || r.offset != end || extents.back().iov.size() >= IOV_MAX) {
+                extents.push_back({r.offset, {}});
+            }
+            extents.back().iov.push_back({r.dst, r.len});
+            end = r.offset + r.len;
+        }
+        return extents;
+    }
+
+    size_t extent_bytes(const std::vector<iovec>& iov) {
+        size_t bytes = 0;
+        for (const auto& v : iov) {
+            bytes += v.iov_len;
+        }
+        return bytes;
+    }
+
+    /**
+     * Reads what is left of an extent after `done` bytes, synchronously.
+     */
+    void finish_with_preadv(int fd, const extent& e, size_t done) {
+        std::vector<iovec> iov = e.iov;
+        size_t skip = done;
+        size_t first = 0;
+        while (first < iov.size() && skip >= iov[first].iov_len) {
+            skip -= iov[first++].iov_len;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + skip;
+            iov[first].iov_len -= skip;
+        }
+        uint64_t offset = e.offset + done;
+        while (first < iov.size()) {
+            const ssize_t n = preadv(fd, iov.data() + first, static_cast<int>(iov.size() - first),
+                                     static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error(n == 0 ? "batch_reader: read past the end of the file"
+                                                : std::string("batch_reader: preadv failed: ") + strerror(errno));
+            }
+            offset += static_cast<uint64_t>(n);
+            size_t left = static_cast<size_t>(n);
+            while (first < iov.size() && left >= iov[first].iov_len) {
+                left -= iov[first++].iov_len;
+            }
+            if (first < iov.size()) {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+                iov[first].iov_len -= left;
+            }
+        }
+    }
+}
+
+struct batch_reader::ring {
+    int fd = -1;
+    void* sq_ptr = MAP_FAILED;
+    void* cq_ptr = MAP_FAILED;
+    size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe* cqes;
+    unsigned entries;
+
+    ~ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool setup(unsigned depth) {
+        io_uring_params p{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &p));
+        if (fd < 0) {
+            return false;
+        }
+        entries = p.sq_entries;
+        sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            return false;
+        }
+        cq_ptr = single ? sq_ptr : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                        IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            return false;
+        }
+        sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                               fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        auto* sq = static_cast<char*>(sq_ptr);
+        auto* cq = static_cast<char*>(cq_ptr);
+        sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    void push(const extent& e, uint64_t user_data, int target) {
+        const unsigned tail = *sq_tail;
+        const unsigned index = tail & *sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = target;
+        sqe.off = e.offset;
+        sqe.addr = reinterpret_cast<uint64_t>(e.iov.data());
+        sqe.len = static_cast<unsigned>(e.iov.size());
+        sqe.user_data = user_data;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Submits `to_submit` entries and waits for at least one completion.
+     */
+    void enter(unsigned to_submit) {
+        while (syscall(__NR_io_uring_enter, fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("batch_reader: io_uring_enter failed: ") + strerror(errno));
+            }
+            to_submit = 0;
+        }
+    }
+};
+
+batch_reader::batch_reader(unsigned queue_depth) : m_iQueueDepth(std::max(1u, queue_depth)) {
+    auto* r = new ring();
+    if (r->setup(m_iQueueDepth)) {
+        m_pRing = r;
+    } else {
+        delete r;
+    }
+}
+
+batch_reader::~batch_reader() {
+    delete m_pRing;
+}
+
+void batch_reader::read(int fd, std::vector<request> requests) {
+    const auto extents = merge(requests);
+    if (!m_pRing) {
+        for (const auto& e : extents) {
+            finish_with_preadv(fd, e, 0);
+        }
+        return;
+    }
+
+    ring& r = *m_pRing;
+    size_t next = 0, inflight = 0;
+    // On an error, the reads in flight are still reaped before throwing: the kernel writes into the buffers until then.
+    std::string error;
+    while ((next < extents.size() && error.empty()) || inflight > 0) {
+        unsigned queued = 0;
+        while (error.empty() && next < extents.size() && inflight < r.entries) {
+            r.push(extents[next], next, fd);
+            next++;
+            inflight++;
+            queued++;
+        }
+        r.enter(queued);
+
+        unsigned head = *r.cq_head;
+        while (head != __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = r.cqes[head & *r.cq_mask];
+            const auto& e = extents[cqe.user_data];
+            const int res = cqe.res;
+            head++;
+            inflight--;
+            if (!error.empty()) {
+                continue;
+            }
+            if (res < 0 && res != -EINTR && res != -EAGAIN) {
+                error = std::string("batch_reader: read failed: ") + strerror(-res);
+                continue;
+            }
+            // A short (or interrupted) read is rare enough to be finished synchronously.
+            const size_t done = res < 0 ? 0 : static_cast<size_t>(res);
+            if (done < extent_bytes(e.iov)) {
+                try {
+                    finish_with_preadv(fd, e, done);
+                } catch (const std::exception& ex) {
+                    error = ex.what();
+                }
+            }
+        }
+        __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
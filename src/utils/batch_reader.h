@@ -0,0 +1,51 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Reads a batch of scattered byte ranges of a file with a queue depth greater than one.
+ * The requests are sorted by offset and the adjacent ones are merged into a single vectored read (one iovec per
+ * request), which is then submitted through io_uring (IORING_OP_READV, up to `queue_depth` reads in flight), set up
+ * through the raw syscalls so that liburing is not needed.
+ *
+ * io_uring may be unavailable (kernels older than 5.1, seccomp filters of containers, io_uring_disabled=2, ...). In that
+ * case every merged read is issued through preadv(2), one after the other; `uses_io_uring()` tells which path is used.
+ */
+class batch_reader {
+public:
+    struct request {
+        uint64_t offset;
+        size_t len;
+        char *dst;
+    };
+
+private:
+    struct ring;
+    ring *m_pRing = nullptr;
+    const unsigned m_iQueueDepth;
+
+public:
+    explicit batch_reader(unsigned queue_depth = 64);
+
+    ~batch_reader();
+
+    batch_reader(const batch_reader&) = delete;
+
+    batch_reader& operator=(const batch_reader&) = delete;
+
+    bool uses_io_uring() const {
+        return m_pRing != nullptr;
+    }
+
+    /**
+     * Fills `dst` of every request with the `len` bytes of `fd` at `offset`. Throws std::runtime_error on an I/O error
+     * or if a range runs past the end of the file.
+     */
+    void read(int fd, std::vector<request> requests);
+};
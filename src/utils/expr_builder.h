@@ -0,0 +1,91 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <algorithm>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/number.h>
+#include <symengine/constants.h>
+
+/**
+ * Accumulates the terms of a sum and canonicalizes them once through `Add::from_dict`.
+ * Building a sum of L terms with `expr = add(expr, term)` copies the whole dictionary of the growing Add on every call,
+ * which is O(L^2) and leaves L short-lived dictionaries behind; this builder does O(L) dictionary insertions instead.
+ * It is the same algorithm as `SymEngine::add(const vec_basic&)`, without requiring the terms to be materialized in a
+ * vector first.
+ *
+ * The builder can be reused after `build()`; it reserves the size of the previous sum for the next one.
+ */
+class add_builder {
+private:
+    SymEngine::umap_basic_num m_mDict;
+    SymEngine::RCP<const SymEngine::Number> m_pCoef = SymEngine::zero;
+    size_t m_lReserve;
+
+public:
+    explicit add_builder(size_t expectedTerms = 0) : m_lReserve(expectedTerms) {
+        m_mDict.reserve(m_lReserve);
+    }
+
+    add_builder& add_term(const SymEngine::RCP<const SymEngine::Basic> &term) {
+        SymEngine::Add::coef_dict_add_term(SymEngine::outArg(m_pCoef), m_mDict, term);
+        return *this;
+    }
+
+    size_t size() const {
+        return m_mDict.size();
+    }
+
+    SymEngine::RCP<const SymEngine::Basic> build() {
+        m_lReserve = std::max(m_lReserve, m_mDict.size());
+        auto result = SymEngine::Add::from_dict(m_pCoef, std::move(m_mDict));
+        m_mDict = SymEngine::umap_basic_num();
+        m_mDict.reserve(m_lReserve);
+        m_pCoef = SymEngine::zero;
+        return result;
+    }
+};
+
+/**
+ * The `Mul` counterpart of `add_builder`: accumulates factors into a base->exponent map and canonicalizes once through
+ * `Mul::from_dict`, like `SymEngine::mul(const vec_basic&)`.
+ */
+class mul_builder {
+private:
+    SymEngine::map_basic_basic m_mDict;
+    SymEngine::RCP<const SymEngine::Number> m_pCoef = SymEngine::one;
+
+public:
+    mul_builder& mul_factor(const SymEngine::RCP<const SymEngine::Basic> &factor) {
+        if (SymEngine::is_a<SymEngine::Mul>(*factor)) {
+            auto m = SymEngine::rcp_static_cast<const SymEngine::Mul>(factor);
+            SymEngine::imulnum(SymEngine::outArg(m_pCoef), m->get_coef());
+            for (const auto &[base, exp] : m->get_dict()) {
+                SymEngine::Mul::dict_add_term_new(SymEngine::outArg(m_pCoef), m_mDict, exp, base);
+            }
+        } else if (SymEngine::is_a_Number(*factor)) {
+            SymEngine::imulnum(SymEngine::outArg(m_pCoef), SymEngine::rcp_static_cast<const SymEngine::Number>(factor));
+        } else {
+            SymEngine::RCP<const SymEngine::Basic> exp, base;
+            SymEngine::Mul::as_base_exp(factor, SymEngine::outArg(exp), SymEngine::outArg(base));
+            SymEngine::Mul::dict_add_term_new(SymEngine::outArg(m_pCoef), m_mDict, exp, base);
+        }
+        return *this;
+    }
+
+    size_t size() const {
+        return m_mDict.size();
+    }
+
+    SymEngine::RCP<const SymEngine::Basic> build() {
+        auto result = SymEngine::Mul::from_dict(m_pCoef, std::move(m_mDict));
+        m_mDict = SymEngine::map_basic_basic();
+        m_pCoef = SymEngine::one;
+        return result;
+    }
+};
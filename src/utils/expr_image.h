@@ -0,0 +1,403 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/pow.h>
+#include <symengine/integer.h>
+#include <symengine/rational.h>
+#include <symengine/symbol.h>
+#include "utils/symtab_codec.h"
+
+/**
+ * An image of a vec_basic that is used in place, right after mmap(2), instead of being deserialized.
+ * Every node of the DAG is written once, after its children, as an 8-byte aligned record that refers to its children by
+ * their offsets from the start of the image (never by pointers), so the image needs no relocation wherever it is mapped:
+ *
+ *  "EXI1" | version (u32) | nodes | roots (u64 offsets) | footer: roots offset, root count, node count (u64), "EXI1"
+ *  node:  kind (u32) | count (u32) | hash (u64) | payload
+ *
+ * The payload is the name of a Symbol (`count` bytes), the value of an Integer that fits a long (i64), the decimal
+ * digits of any other Integer or of a Rational ("num/den", `count` bytes), the offsets of the children (base, exp of
+ * a Pow; coef then `count` (key, value) pairs of an Add or a Mul), or the `Basic::dumps()` blob of any other node. The
+ * integers are in the native byte order, the footer tells a foreign one apart. The hash of every node is the SymEngine
+ * hash, so the exprs can be compared and looked up without being rebuilt.
+ *
+ * `expr_image` maps the file read-only and hands out `expr_image::node` views: reading a node touches its page and
+ * nothing else, with no allocation. `materialize()` is the relocation pass for the callers that need real Basics: it
+ * rebuilds a root (and caches every rebuilt node, so the roots share their nodes as with `loads_vec()`).
+ *
+ * Usage:
+ *  mmap_streambuf buf("exprs.img");
+ *  std::ostream os(&buf);
+ *  dump_image(os, exprs);
+ *  buf.close();
+ *  expr_image img("exprs.img");
+ *  for (size_t k = 0; k < img.root(0).count(); k++) { use(img.root(0).key(k)); }
+ */
+class expr_image {
+public:
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    enum kind : uint32_t {
+        SYMBOL = 1,
+        INTEGER,
+        INTEGER_BIG,
+        RATIONAL,
+        ADD,
+        MUL,
+        POW,
+        BLOB
+    };
+
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 8;
+    static constexpr size_t NODE_BYTES = 16;
+    static constexpr size_t FOOTER_BYTES = 32;
+
+    class node {
+    private:
+        const char *m_pBase;
+        uint64_t m_lOffset;
+
+        template<typename T>
+        T load(uint64_t at) const {
+            T v;
+            std::memcpy(&v, m_pBase + at, sizeof(T));
+            return v;
+        }
+
+        const char *payload() const {
+            return m_pBase + m_lOffset + NODE_BYTES;
+        }
+
+    public:
+        node(const char *base, uint64_t offset) : m_pBase(base), m_lOffset(offset) {}
+
+        uint64_t offset() const {
+            return m_lOffset;
+        }
+
+        kind type() const {
+            return static_cast<kind>(load<uint32_t>(m_lOffset));
+        }
+
+        /**
+         * @return The number of bytes of a Symbol, big Integer or blob, the number of pairs of an Add or a Mul.
+         */
+        uint32_t count() const {
+            return load<uint32_t>(m_lOffset + 4);
+        }
+
+        SymEngine::hash_t hash() const {
+            return static_cast<SymEngine::hash_t>(load<uint64_t>(m_lOffset + 8));
+        }
+
+        /**
+         * @return The name of a Symbol, the digits of a big Integer or a Rational, or the blob of any other node.
+         */
+        std::string_view bytes() const {
+            return {payload(), count()};
+        }
+
+        /**
+         * @return The value of an Integer that fits a long.
+         */
+        long value() const {
+            return static_cast<long>(load<int64_t>(m_lOffset + NODE_BYTES));
+        }
+
+        /**
+         * @return The k-th child: base, exp of a Pow; coef, key_0, value_0, ... of an Add or a Mul.
+         */
+        node child(size_t k) const {
+            return {m_pBase, load<uint64_t>(m_lOffset + NODE_BYTES + 8 * k)};
+        }
+
+        size_t child_count() const {
+            switch (type()) {
+                case POW:
+                    return 2;
+                case ADD:
+                case MUL:
+                    return 1 + 2 * static_cast<size_t>(count());
+                default:
+                    return 0;
+            }
+        }
+
+        node coef() const {
+            return child(0);
+        }
+
+        node key(size_t k) const {
+            return child(1 + 2 * k);
+        }
+
+        node val(size_t k) const {
+            return child(2 + 2 * k);
+        }
+    };
+
+private:
+    const char *m_pBase = nullptr;
+    size_t m_lSize = 0;
+    uint64_t m_lRoots = 0, m_lRootCount = 0, m_lNodeCount = 0;
+    std::unordered_map<uint64_t, rcp_basic> m_mMaterialized;
+
+    template<typename T>
+    T load(uint64_t at) const {
+        T v;
+        std::memcpy(&v, m_pBase + at, sizeof(T));
+        return v;
+    }
+
+    rcp_basic build(const node &n) const {
+        auto at = [&](size_t k) -> const rcp_basic & {
+            return m_mMaterialized.at(n.child(k).offset());
+        };
+        auto number = [&](size_t k) {
+            return SymEngine::rcp_static_cast<const SymEngine::Number>(at(k));
+        };
+        switch (n.type()) {
+            case SYMBOL:
+                return SymEngine::symbol(std::string(n.bytes()));
+            case INTEGER:
+                return SymEngine::integer(n.value());
+            case INTEGER_BIG:
+                return SymEngine::integer(SymEngine::integer_class(std::string(n.bytes())));
+            case RATIONAL: {
+                const std::string digits(n.bytes());
+                const size_t slash = digits.find('/');
+                if (slash == std::string::npos) {
+                    throw std::runtime_error("Invalid Rational in the image");
+                }
+                return SymEngine::Rational::from_two_ints(
+                    *SymEngine::integer(SymEngine::integer_class(digits.substr(0, slash))),
+                    *SymEngine::integer(SymEngine::integer_class(digits.substr(slash + 1))));
+            }
+            case ADD: {
+                SymEngine::umap_basic_num dict;
+                dict.reserve(n.count());
+                for (size_t k = 0; k < n.count(); k++) {
+                    dict[at(1 + 2 * k)] = number(2 + 2 * k);
+                }
+                return SymEngine::Add::from_dict(number(0), std::move(dict));
+            }
+            case MUL: {
+                SymEngine::map_basic_basic dict;
+                for (size_t k = 0; k < n.count(); k++) {
+                    dict[at(1 + 2 * k)] = at(2 + 2 * k);
+                }
+                return SymEngine::Mul::from_dict(number(0), std::move(dict));
+            }
+            case POW:
+                return SymEngine::make_rcp<const SymEngine::Pow>(at(0), at(1));
+            case BLOB:
+                return SymEngine::Basic::loads(std::string(n.bytes()));
+            default:
+                throw std::runtime_error("Invalid node kind in the image");
+        }
+    }
+
+public:
+    explicit expr_image(const std::string &path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open image " + path);
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES + FOOTER_BYTES) {
+            close(fd);
+            throw std::runtime_error("Not an expr image: " + path);
+        }
+        m_lSize = static_cast<size_t>(st.st_size);
+        void *p = mmap(nullptr, m_lSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("Cannot map image " + path);
+        }
+        m_pBase = static_cast<const char *>(p);
+
+        const size_t footer = m_lSize - FOOTER_BYTES;
+        m_lRoots = load<uint64_t>(footer);
+        m_lRootCount = load<uint64_t>(footer + 8);
+        m_lNodeCount = load<uint64_t>(footer + 16);
+        if (std::memcmp(m_pBase, "EXI1", 4) != 0 || std::memcmp(m_pBase + footer + 24, "EXI1", 4) != 0 ||
+            load<uint32_t>(4) != VERSION || load<uint32_t>(footer + 28) != VERSION ||
+            m_lRoots > footer || (footer - m_lRoots) / 8 < m_lRootCount) {
+            munmap(const_cast<char *>(m_pBase), m_lSize);
+            throw std::runtime_error("Invalid or foreign-endian expr image: " + path);
+        }
+    }
+
+    ~expr_image() {
+        munmap(const_cast<char *>(m_pBase), m_lSize);
+    }
+
+    expr_image(const expr_image&) = delete;
+
+    expr_image& operator=(const expr_image&) = delete;
+
+    size_t size() const {
+        return m_lRootCount;
+    }
+
+    size_t node_count() const {
+        return m_lNodeCount;
+    }
+
+    size_t bytes() const {
+        return m_lSize;
+    }
+
+    node root(size_t i) const {
+        if (i >= m_lRootCount) {
+            throw std::out_of_range("Invalid root index " + std::to_string(i));
+        }
+        const uint64_t offset = load<uint64_t>(m_lRoots + 8 * i);
+        if (offset < HEADER_BYTES || offset >= m_lRoots) {
+            throw std::runtime_error("Invalid root offset in the image");
+        }
+        return {m_pBase, offset};
+    }
+
+    /**
+     * Rebuilds the Basic of a node. The children of a node always precede it in the image, which bounds the walk even
+     * on a corrupted image.
+     */
+    rcp_basic materialize(const node &n) {
+        std::vector<std::pair<node, bool>> stack{{n, false}};
+        while (!stack.empty()) {
+            auto [x, expanded] = stack.back();
+            stack.pop_back();
+            if (m_mMaterialized.count(x.offset())) {
+                continue;
+            }
+            if (expanded) {
+                m_mMaterialized.emplace(x.offset(), build(x));
+                continue;
+            }
+            stack.emplace_back(x, true);
+            for (size_t k = 0; k < x.child_count(); k++) {
+                const node c = x.child(k);
+                if (c.offset() < HEADER_BYTES || c.offset() >= x.offset()) {
+                    throw std::runtime_error("Invalid child offset in the image");
+                }
+                if (!m_mMaterialized.count(c.offset())) {
+                    stack.emplace_back(c, false);
+                }
+            }
+        }
+        return m_mMaterialized.at(n.offset());
+    }
+
+    rcp_basic materialize(size_t i) {
+        return materialize(root(i));
+    }
+};
+
+/**
+ * Writes the image of `exprs` to `os` (see expr_image), without building it in memory first.
+ * @return The number of bytes written.
+ */
+inline size_t dump_image(std::ostream &os, const SymEngine::vec_basic &exprs) {
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+    std::unordered_map<const SymEngine::Basic *, uint64_t> offsets;
+    uint64_t pos = 0;
+    std::string record;
+
+    auto put = [&record](const auto &v) {
+        record.append(reinterpret_cast<const char *>(&v), sizeof(v));
+    };
+    auto flush = [&]() {
+        record.resize((record.size() + 7) / 8 * 8, '\0');
+        os.write(record.data(), static_cast<std::streamsize>(record.size()));
+        pos += record.size();
+        record.clear();
+    };
+    auto header = [&](expr_image::kind k, size_t count, const SymEngine::Basic &b) {
+        if (count > UINT32_MAX) {
+            throw std::runtime_error("Node too large for an expr image");
+        }
+        put(static_cast<uint32_t>(k));
+        put(static_cast<uint32_t>(count));
+        put(static_cast<uint64_t>(b.hash()));
+    };
+    auto child = [&](const rcp_basic &c) {
+        put(offsets.at(c.get()));
+    };
+    auto bytes = [&](expr_image::kind k, const std::string &s, const SymEngine::Basic &b) {
+        header(k, s.size(), b);
+        record += s;
+    };
+
+    auto write_node = [&](const rcp_basic &x) {
+        const SymEngine::Basic &b = *x;
+        if (SymEngine::is_a<SymEngine::Symbol>(b)) {
+            bytes(expr_image::SYMBOL, SymEngine::down_cast<const SymEngine::Symbol &>(b).get_name(), b);
+        } else if (SymEngine::is_a<SymEngine::Integer>(b)) {
+            const auto &i = SymEngine::down_cast<const SymEngine::Integer &>(b).as_integer_class();
+            if (SymEngine::mp_fits_slong_p(i)) {
+                header(expr_image::INTEGER, 0, b);
+                put(static_cast<int64_t>(SymEngine::mp_get_si(i)));
+            } else {
+                bytes(expr_image::INTEGER_BIG, b.__str__(), b);
+            }
+        } else if (SymEngine::is_a<SymEngine::Rational>(b)) {
+            // The num and den of a Rational are not nodes of the DAG (get_num() builds a new Integer).
+            bytes(expr_image::RATIONAL, b.__str__(), b);
+        } else if (SymEngine::is_a<SymEngine::Add>(b)) {
+            header(expr_image::ADD, SymEngine::down_cast<const SymEngine::Add &>(b).get_dict().size(), b);
+            symtab_detail::for_each_child(b, child);
+        } else if (SymEngine::is_a<SymEngine::Mul>(b)) {
+            header(expr_image::MUL, SymEngine::down_cast<const SymEngine::Mul &>(b).get_dict().size(), b);
+            symtab_detail::for_each_child(b, child);
+        } else if (SymEngine::is_a<SymEngine::Pow>(b)) {
+            header(expr_image::POW, 0, b);
+            symtab_detail::for_each_child(b, child);
+        } else {
+            bytes(expr_image::BLOB, b.dumps(), b);
+        }
+        offsets.emplace(&b, pos);
+        flush();
+    };
+
+    record = "EXI1";
+    put(expr_image::VERSION);
+    flush();
+
+    symtab_detail::for_each_post_order(exprs, [&](const rcp_basic &x) {
+        return offsets.count(x.get()) != 0;
+    }, write_node);
+
+    const uint64_t roots = pos;
+    for (const auto &e : exprs) {
+        child(e);
+    }
+    flush();
+    put(roots);
+    put(static_cast<uint64_t>(exprs.size()));
+    put(static_cast<uint64_t>(offsets.size()));
+    record += "EXI1";
+    put(expr_image::VERSION);
+    flush();
+    return static_cast<size_t>(pos);
+}
@@ -0,0 +1,321 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <array>
+#include <iterator>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/pow.h>
+#include <symengine/symbol.h>
+#include <symengine/integer.h>
+
+/**
+ * An opt-in, process-wide unique table for SymEngine nodes (hash-consing).
+ * SymEngine itself always allocates a new node, so structurally equal sub-expressions built independently (e.g. the
+ * `a_j + b_j + c_j` bases of every expr of bench01) exist once per construction. Building through the `hc::` wrappers
+ * instead consults the table before allocating:
+ *  - `hc::symbol(name)` looks the name up, and `hc::integer(n)` the value, so a hit allocates nothing.
+ *  - `hc::add/mul/pow(a, b)` look the operation up by the identity of its (canonical) operands, so a repeated
+ *    construction is a table hit and allocates nothing.
+ *  - Any other node can be canonicalized with `intern()`, which finds the structurally equal node if there is one.
+ * Nodes that are built this way are unique, so `hc::same(a, b)` (a pointer compare) is an equality check.
+ *
+ * The table is sharded by hash, each shard with its own mutex. SymEngine's RCP has no weak references, so the table
+ * holds strong ones and `collect()` provides the weak semantics: it drops every entry that nothing outside the table
+ * references anymore, which lets those nodes die.
+ */
+class hash_cons {
+public:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    enum op_code : uint8_t {
+        OP_ADD = 1,
+        OP_MUL,
+        OP_POW
+    };
+
+    struct stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t nodes;
+        size_t ops;
+        size_t symbols;
+        size_t integers;
+    };
+
+private:
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    struct op_key {
+        op_code op;
+        rcp_basic a, b; // held, so that the addresses used by the hash stay valid
+
+        bool operator==(const op_key& other) const {
+            return op == other.op && a.get() == other.a.get() && b.get() == other.b.get();
+        }
+    };
+
+    struct op_key_hash {
+        size_t operator()(const op_key& k) const {
+            size_t h = std::hash<const void*>()(k.a.get());
+            h ^= std::hash<const void*>()(k.b.get()) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            return h ^ (static_cast<size_t>(k.op) * 0xff51afd7ed558ccdull);
+        }
+    };
+
+    struct shard {
+        std::mutex mutex;
+        std::unordered_set<rcp_basic, SymEngine::RCPBasicHash, SymEngine::RCPBasicKeyEq> nodes;
+        std::unordered_map<op_key, rcp_basic, op_key_hash> ops;
+        std::unordered_map<std::string, rcp_basic> symbols;
+        std::unordered_map<long, rcp_basic> integers;
+    };
+
+    std::array<shard, SHARD_COUNT> m_aShards;
+    std::atomic<bool> m_bEnabled{false};
+    std::atomic<uint64_t> m_lHits{0};
+    std::atomic<uint64_t> m_lMisses{0};
+
+    shard& shard_of(size_t h) {
+        return m_aShards[(h ^ (h >> 17)) % SHARD_COUNT];
+    }
+
+public:
+    static hash_cons& instance() {
+        static hash_cons s_oInstance;
+        return s_oInstance;
+    }
+
+    void enable() {
+        m_bEnabled.store(true);
+    }
+
+    void disable() {
+        m_bEnabled.store(false);
+    }
+
+    bool enabled() const {
+        return m_bEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return The unique node structurally equal to `x`, registering `x` as such if there is none yet.
+     */
+    rcp_basic intern(const rcp_basic& x) {
+        auto &s = shard_of(x->hash());
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.nodes.find(x);
+        if (it != s.nodes.end()) {
+            m_lHits++;
+            return *it;
+        }
+        m_lMisses++;
+        s.nodes.insert(x);
+        return x;
+    }
+
+    rcp_basic symbol(const std::string& name) {
+        auto &s = shard_of(std::hash<std::string>()(name));
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.symbols.find(name);
+            if (it != s.symbols.end()) {
+                m_lHits++;
+                return it->second;
+            }
+        }
+        auto node = intern(SymEngine::symbol(name));
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.symbols.emplace(name, node).first->second;
+    }
+
+    rcp_basic integer(long n) {
+        auto &s = shard_of(std::hash<long>()(n));
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.integers.find(n);
+            if (it != s.integers.end()) {
+                m_lHits++;
+                return it->second;
+            }
+        }
+        auto node = intern(SymEngine::integer(n));
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.integers.emplace(n, node).first->second;
+    }
+
+    /**
+     * Looks `op(a, b)` up by the identity of its canonical operands and only calls `build` on a miss.
+     */
+    template <typename BuildFn>
+    rcp_basic apply(op_code op, const rcp_basic& a, const rcp_basic& b, BuildFn&& build) {
+        op_key key{op, intern(a), intern(b)};
+        auto &s = shard_of(op_key_hash()(key));
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.ops.find(key);
+            if (it != s.ops.end()) {
+                m_lHits++;
+                return it->second;
+            }
+        }
+        auto node = intern(build(key.a, key.b));
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.ops.emplace(std::move(key), node).first->second;
+    }
+
+    /**
+     * Drops the entries that are only referenced by the table itself, repeating until nothing else becomes
+     * collectable (a dropped parent releases its children). Must not run concurrently with the `hc::` wrappers.
+     * @return The number of dropped nodes.
+     */
+    size_t collect() {
+        size_t dropped = 0;
+        while (true) {
+            // How many references to each node the table holds.
+            std::unordered_map<const SymEngine::Basic*, size_t> internal;
+            for (auto &s : m_aShards) {
+                for (auto &n : s.nodes) {
+                    internal[n.get()]++;
+                }
+                for (auto &[k, v] : s.ops) {
+                    internal[k.a.get()]++;
+                    internal[k.b.get()]++;
+                    internal[v.get()]++;
+                }
+                for (auto &[k, v] : s.symbols) {
+                    internal[v.get()]++;
+                }
+                for (auto &[k, v] : s.integers) {
+                    internal[v.get()]++;
+                }
+            }
+            std::unordered_set<const SymEngine::Basic*> dead;
+            for (auto &s : m_aShards) {
+                for (auto &n : s.nodes) {
+                    if (n.use_count() <= internal[n.get()]) {
+                        dead.insert(n.get());
+                    }
+                }
+            }
+            if (dead.empty()) {
+                break;
+            }
+            for (auto &s : m_aShards) {
+                for (auto it = s.ops.begin(); it != s.ops.end();) {
+                    if (dead.count(it->first.a.get()) || dead.count(it->first.b.get()) ||
+                        dead.count(it->second.get())) {
+                        it = s.ops.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                for (auto it = s.symbols.begin(); it != s.symbols.end();) {
+                    it = dead.count(it->second.get()) ? s.symbols.erase(it) : std::next(it);
+                }
+                for (auto it = s.integers.begin(); it != s.integers.end();) {
+                    it = dead.count(it->second.get()) ? s.integers.erase(it) : std::next(it);
+                }
+                for (auto it = s.nodes.begin(); it != s.nodes.end();) {
+                    it = dead.count(it->get()) ? s.nodes.erase(it) : std::next(it);
+                }
+            }
+            dropped += dead.size();
+        }
+        return dropped;
+    }
+
+    void clear() {
+        for (auto &s : m_aShards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.ops.clear();
+            s.symbols.clear();
+            s.integers.clear();
+            s.nodes.clear();
+        }
+        m_lHits = 0;
+        m_lMisses = 0;
+    }
+
+    stats get_stats() {
+        stats st{m_lHits.load(), m_lMisses.load(), 0, 0, 0, 0};
+        for (auto &s : m_aShards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            st.nodes += s.nodes.size();
+            st.ops += s.ops.size();
+            st.symbols += s.symbols.size();
+            st.integers += s.integers.size();
+        }
+        return st;
+    }
+};
+
+/**
+ * Constructors that go through the unique table when it is enabled, and fall back to plain SymEngine otherwise.
+ */
+namespace hc {
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    inline rcp_basic symbol(const std::string& name) {
+        auto &t = hash_cons::instance();
+        return t.enabled() ? t.symbol(name) : SymEngine::symbol(name);
+    }
+
+    inline rcp_basic integer(long n) {
+        auto &t = hash_cons::instance();
+        return t.enabled() ? t.integer(n) : SymEngine::integer(n);
+    }
+
+    inline rcp_basic add(const rcp_basic& a, const rcp_basic& b) {
+        auto &t = hash_cons::instance();
+        if (!t.enabled()) {
+            return SymEngine::add(a, b);
+        }
+        return t.apply(hash_cons::OP_ADD, a, b, [](const rcp_basic& x, const rcp_basic& y) {
+            return SymEngine::add(x, y);
+        });
+    }
+
+    inline rcp_basic mul(const rcp_basic& a, const rcp_basic& b) {
+        auto &t = hash_cons::instance();
+        if (!t.enabled()) {
+            return SymEngine::mul(a, b);
+        }
+        return t.apply(hash_cons::OP_MUL, a, b, [](const rcp_basic& x, const rcp_basic& y) {
+            return SymEngine::mul(x, y);
+        });
+    }
+
+    inline rcp_basic pow(const rcp_basic& a, const rcp_basic& b) {
+        auto &t = hash_cons::instance();
+        if (!t.enabled()) {
+            return SymEngine::pow(a, b);
+        }
+        return t.apply(hash_cons::OP_POW, a, b, [](const rcp_basic& x, const rcp_basic& y) {
+            return SymEngine::pow(x, y);
+        });
+    }
+
+    inline rcp_basic intern(const rcp_basic& x) {
+        auto &t = hash_cons::instance();
+        return t.enabled() ? t.intern(x) : x;
+    }
+
+    /**
+     * Equality of two nodes built through `hc::`; a pointer compare when the table is enabled.
+     */
+    inline bool same(const rcp_basic& a, const rcp_basic& b) {
+        return hash_cons::instance().enabled() ? a.get() == b.get() : SymEngine::eq(*a, *b);
+    }
+}
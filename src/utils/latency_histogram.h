@@ -0,0 +1,158 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+/**
+ * An HDR-style, log-bucketed latency histogram with integer nanosecond resolution.
+ * Values are grouped by their most significant bit and each power of two is split into SUB_BUCKET_HALF linear
+ * sub-buckets, so the relative error of any reported percentile is bounded by 1/SUB_BUCKET_HALF (~1.6%) over the
+ * whole uint64_t range, while the memory footprint stays constant no matter how many samples are recorded.
+ *
+ * Instances with the same layout can be merged, which is what allows per-thread histograms to be combined at the end
+ * of a phase.
+ */
+class latency_histogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF;
+
+private:
+    std::vector<uint64_t> m_vCounts;
+    uint64_t m_lCount = 0;
+    uint64_t m_lMin = std::numeric_limits<uint64_t>::max();
+    uint64_t m_lMax = 0;
+    // Welford's running mean and sum of squared deviations, in ns.
+    double m_dMean = 0;
+    double m_dM2 = 0;
+
+public:
+    latency_histogram() : m_vCounts(BUCKET_COUNT, 0) {
+    }
+
+    static inline size_t index_of(uint64_t ns) {
+        if (ns < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(ns);
+        }
+        const unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+        const unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+        return static_cast<size_t>(shift * SUB_BUCKET_HALF + (ns >> shift));
+    }
+
+    static inline uint64_t lower_bound_of(size_t index) {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+        const uint64_t shift = index / SUB_BUCKET_HALF - 1;
+        const uint64_t sub = index % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+        return sub << shift;
+    }
+
+    static inline uint64_t upper_bound_of(size_t index) {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+        const uint64_t shift = index / SUB_BUCKET_HALF - 1;
+        return lower_bound_of(index) + ((1ull << shift) - 1);
+    }
+
+    inline void record(uint64_t ns) {
+        m_vCounts[index_of(ns)]++;
+        m_lCount++;
+        m_lMin = std::min(m_lMin, ns);
+        m_lMax = std::max(m_lMax, ns);
+        const double delta = static_cast<double>(ns) - m_dMean;
+        m_dMean += delta / static_cast<double>(m_lCount);
+        m_dM2 += delta * (static_cast<double>(ns) - m_dMean);
+    }
+
+    void merge(const latency_histogram& other) {
+        if (other.m_lCount == 0) {
+            return;
+        }
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            m_vCounts[i] += other.m_vCounts[i];
+        }
+        // Chan et al. parallel variance combination.
+        const double na = static_cast<double>(m_lCount);
+        const double nb = static_cast<double>(other.m_lCount);
+        const double delta = other.m_dMean - m_dMean;
+        m_dMean = (na * m_dMean + nb * other.m_dMean) / (na + nb);
+        m_dM2 += other.m_dM2 + delta * delta * na * nb / (na + nb);
+        m_lCount += other.m_lCount;
+        m_lMin = std::min(m_lMin, other.m_lMin);
+        m_lMax = std::max(m_lMax, other.m_lMax);
+    }
+
+    void reset() {
+        std::fill(m_vCounts.begin(), m_vCounts.end(), 0);
+        m_lCount = 0;
+        m_lMin = std::numeric_limits<uint64_t>::max();
+        m_lMax = 0;
+        m_dMean = 0;
+        m_dM2 = 0;
+    }
+
+    uint64_t count() const {
+        return m_lCount;
+    }
+
+    uint64_t min() const {
+        return m_lCount == 0 ? 0 : m_lMin;
+    }
+
+    uint64_t max() const {
+        return m_lMax;
+    }
+
+    double mean() const {
+        return m_dMean;
+    }
+
+    double variance() const {
+        return m_lCount == 0 ? 0 : m_dM2 / static_cast<double>(m_lCount);
+    }
+
+    /**
+     * @param p The percentile in [0, 100].
+     * @return The highest value equivalent to the bucket holding the p-th percentile, clamped to [min, max].
+     */
+    uint64_t percentile(double p) const {
+        if (m_lCount == 0) {
+            return 0;
+        }
+        p = std::min(100.0, std::max(0.0, p));
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(m_lCount)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += m_vCounts[i];
+            if (seen >= rank) {
+                return std::min(m_lMax, std::max(m_lMin, upper_bound_of(i)));
+            }
+        }
+        return m_lMax;
+    }
+
+    /**
+     * Calls `fn(lower_ns, upper_ns, count)` for every non-empty bucket in increasing order.
+     */
+    template <typename Fn>
+    void for_each_bucket(Fn&& fn) const {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            if (m_vCounts[i] != 0) {
+                fn(lower_bound_of(i), upper_bound_of(i), m_vCounts[i]);
+            }
+        }
+    }
+};
@@ -0,0 +1,222 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include "utils/expr_builder.h"
+
+/**
+ * A serialized form of an expr that can be loaded term by term.
+ * `Basic::loads()` always materializes the whole DAG, even when only the number of terms or a few of them are needed.
+ * `dumps_lazy()` writes the top-level terms of a sum (the args of the Add) as independent `Basic::dumps()` blobs
+ * behind an offset table:
+ *
+ *  "LZS1" | is_sum (u8) | count (u64) | offsets[count + 1] (u64, relative to the payload) | payload
+ *
+ * All the integers are little-endian. An expr that is not an Add is stored as a single term.
+ * `lazy_sum` only reads the header and the offset table when it is opened; every term is deserialized when it is
+ * touched for the first time. The terms do not share their nodes (the symbols are written once per term), which is
+ * the price of the random access.
+ */
+inline std::string dumps_lazy(const SymEngine::RCP<const SymEngine::Basic> &expr) {
+    const bool isSum = SymEngine::is_a<SymEngine::Add>(*expr);
+    const SymEngine::vec_basic children = isSum ? expr->get_args() : SymEngine::vec_basic{expr};
+
+    std::vector<std::string> blobs;
+    blobs.reserve(children.size());
+    for (const auto &c : children) {
+        blobs.push_back(c->dumps());
+    }
+
+    std::string out = "LZS1";
+    auto put_u64 = [&out](uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+        }
+    };
+    out.push_back(static_cast<char>(isSum ? 1 : 0));
+    put_u64(blobs.size());
+    uint64_t offset = 0;
+    for (const auto &b : blobs) {
+        put_u64(offset);
+        offset += b.size();
+    }
+    put_u64(offset);
+    for (const auto &b : blobs) {
+        out += b;
+    }
+    return out;
+}
+
+class lazy_sum {
+private:
+    // Reads `len` bytes at `offset` of the serialized form.
+    class source {
+    public:
+        virtual ~source() = default;
+        virtual std::string read(uint64_t offset, uint64_t len) = 0;
+    };
+
+    class string_source : public source {
+        const std::string m_sData;
+    public:
+        explicit string_source(std::string data) : m_sData(std::move(data)) {}
+
+        std::string read(uint64_t offset, uint64_t len) override {
+            if (offset + len > m_sData.size()) {
+                throw std::runtime_error("Truncated lazy sum");
+            }
+            return m_sData.substr(offset, len);
+        }
+    };
+
+    class file_source : public source {
+        std::ifstream m_oFile;
+        const uint64_t m_lBase;
+    public:
+        file_source(const std::string &path, uint64_t base) : m_oFile(path, std::ios::binary), m_lBase(base) {
+            if (!m_oFile) {throw std::runtime_error("Cannot open file " + path);}
+        }
+
+        std::string read(uint64_t offset, uint64_t len) override {
+            std::string data(len, '\0');
+            m_oFile.seekg(static_cast<std::streamoff>(m_lBase + offset));
+            m_oFile.read(&data[0], static_cast<std::streamsize>(len));
+            if (!m_oFile) {
+                throw std::runtime_error("Truncated lazy sum");
+            }
+            return data;
+        }
+    };
+
+    std::unique_ptr<source> m_pSource;
+    bool m_bIsSum = false;
+    std::vector<uint64_t> m_vOffsets;
+    uint64_t m_lPayload = 0;
+    SymEngine::vec_basic m_vTerms;
+    size_t m_lLoaded = 0;
+    uint64_t m_lBytesRead = 0;
+
+    static uint64_t get_u64(const std::string &data, size_t pos) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) {
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        return v;
+    }
+
+    explicit lazy_sum(std::unique_ptr<source> src) : m_pSource(std::move(src)) {
+        const auto header = m_pSource->read(0, 13);
+        if (header.compare(0, 4, "LZS1") != 0) {
+            throw std::runtime_error("Not a lazy sum");
+        }
+        m_bIsSum = header[4] != 0;
+        const uint64_t count = get_u64(header, 5);
+        const auto table = m_pSource->read(13, 8 * (count + 1));
+        m_vOffsets.resize(count + 1);
+        for (size_t i = 0; i <= count; i++) {
+            m_vOffsets[i] = get_u64(table, 8 * i);
+        }
+        m_lPayload = 13 + 8 * (count + 1);
+        m_lBytesRead = m_lPayload;
+        m_vTerms.resize(count);
+    }
+
+public:
+    /**
+     * Opens a lazy sum held in memory, e.g. an element read through CFileWriterBase<std::string>.
+     */
+    static lazy_sum from_string(std::string data) {
+        return lazy_sum(std::make_unique<string_source>(std::move(data)));
+    }
+
+    /**
+     * Opens a lazy sum stored in a file at `offset`. The file stays open until the lazy sum is destroyed.
+     */
+    static lazy_sum from_file(const std::string &path, uint64_t offset = 0) {
+        return lazy_sum(std::make_unique<file_source>(path, offset));
+    }
+
+    /**
+     * @return The number of top-level terms, without loading any of them.
+     */
+    size_t size() const {
+        return m_vTerms.size();
+    }
+
+    bool is_sum() const {
+        return m_bIsSum;
+    }
+
+    /**
+     * @return The number of bytes term `i` takes in the serialized form.
+     */
+    uint64_t term_bytes(size_t i) const {
+        return m_vOffsets.at(i + 1) - m_vOffsets.at(i);
+    }
+
+    /**
+     * Deserializes term `i` on its first access and keeps it for the next ones.
+     */
+    const SymEngine::RCP<const SymEngine::Basic> &term(size_t i) {
+        auto &t = m_vTerms.at(i);
+        if (t.is_null()) {
+            t = SymEngine::Basic::loads(m_pSource->read(m_lPayload + m_vOffsets[i], term_bytes(i)));
+            m_lLoaded++;
+            m_lBytesRead += term_bytes(i);
+        }
+        return t;
+    }
+
+    size_t loaded_count() const {
+        return m_lLoaded;
+    }
+
+    /**
+     * @return The number of bytes read from the serialized form so far.
+     */
+    uint64_t bytes_read() const {
+        return m_lBytesRead;
+    }
+
+    /**
+     * Drops the loaded terms (the ones still referenced by the caller stay alive).
+     */
+    void release() {
+        for (auto &t : m_vTerms) {
+            t.reset();
+        }
+        m_lLoaded = 0;
+    }
+
+    template<typename Fn>
+    void for_each_term(Fn &&fn) {
+        for (size_t i = 0; i < size(); i++) {
+            fn(term(i));
+        }
+    }
+
+    /**
+     * Loads every term and rebuilds the expr, canonicalizing the sum once.
+     */
+    SymEngine::RCP<const SymEngine::Basic> materialize() {
+        if (!m_bIsSum) {
+            return term(0);
+        }
+        add_builder builder(size());
+        for_each_term([&](const SymEngine::RCP<const SymEngine::Basic> &t) {
+            builder.add_term(t);
+        });
+        return builder.build();
+    }
+};
@@ -4,9 +4,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <ctime>
@@ -15,52 +19,190 @@
 #include <malloc.h>
 #include <map>
 #include <sstream>
+#include <unistd.h>
 
+#include "timers.h"
+
+/**
+ * The process-wide memory sampler: a single thread that samples the memory usage of the process every `interval` ms
+ * into one trace, on the monotonic clock. The phases of the workload push begin/end markers (`phaseBegin()` and
+ * `phaseEnd()`) into the same timeline, and every marker carries a sample taken at that very instant, so the peak and
+ * the delta of every phase are exact at its boundaries and do not need several trackers (and sampler threads) to be
+ * aligned afterward. The trace is a compact CSV, read by `plot_mem_usage.py`:
+ *
+ *  # mem_usage_tracker <wall-clock time of t = 0>
+ *  S|B|E,t_ms,vm_gb,rss_gb,allocated_gb,in_use_gb,free_gb[,phase]
+ *  P,phase,begin_ms,end_ms,rss_begin_gb,rss_end_gb,rss_peak_gb,in_use_peak_gb
+ *
+ * `S` is a periodic sample, `B`/`E` the begin/end of a phase and `P` the summary written when a phase ends.
+ *
+ * A soft limit (`setSoftLimit()`) on the RSS calls back the owner of the memory (e.g. a spill manager) from the sampler
+ * thread, so that it can release some of it. The hard limit on the virtual size (`memUsageLimit`) exits the process,
+ * but only as a last resort: the soft limit callback, if any, is first asked to release all it can, and is given a
+ * bounded time to do so.
+ *
+ * Usage:
+ *  auto &tracker = mem_usage_tracker::instance();
+ *  tracker.start(100, 100, "mem_usage_bench.txt");
+ *  tracker.phaseBegin("load");
+ *  ...
+ *  tracker.phaseEnd("load");
+ *  tracker.stop();
+ */
 class mem_usage_tracker {
 protected:
-    struct DataPoint {
-        double memoryUsageInGB;
-        double totalAllocatedSpace;
-        double totalInUseSpace;
-        double totalFreeSpace;
-        double externalFragmentation;
-        char timeOfSample[24];
-
-        DataPoint(double memUsage, double totalAllocated, double totalInUse,
-                  double totalFree, double extFrag, std::string time)
-            : memoryUsageInGB(memUsage), totalAllocatedSpace(totalAllocated),
-              totalInUseSpace(totalInUse), totalFreeSpace(totalFree),
-              externalFragmentation(extFrag) {
-            for (size_t i = 0; i < time.size(); i++) {
-                timeOfSample[i] = time[i];
-            }
-        }
+    struct Sample {
+        double tMs;
+        double vmGigs;
+        double rssGigs;
+        double allocatedGigs;
+        double inUseGigs;
+        double freeGigs;
+    };
+
+    struct OpenPhase {
+        std::string name;
+        Sample begin;
+        double rssPeak;
+        double inUsePeak;
     };
 
-    const size_t m_iWriteEvery = 3;
     const size_t m_iFlushEvery = 8;
-    const int m_iInterval;
-    const double m_dMemUsageLimit;
-    const std::string m_strFilePath;
-    std::atomic<bool> stopFlag;
+    // How long the hard limit waits for the owner of the soft limit callback to release the memory before exiting.
+    const int m_iHardLimitGraceMs = 2000;
+    int m_iInterval = 100;
+    double m_dMemUsageLimit = 0;
+    bool m_bSilent = false;
+    uint64_t m_lOriginNs = 0;
+    std::atomic<bool> stopFlag{true};
     std::thread m_oThread;
-    std::vector<DataPoint> m_vPendingWrite;
+    // Guards the trace file and the open phases, which are written by the sampler and by the phase markers.
+    std::mutex m_oMutex;
     std::ofstream m_oFile;
+    std::vector<OpenPhase> m_vOpenPhases;
     size_t m_lCounter = 0;
-    const bool m_bSilent;
+    std::mutex m_oMutexPressure;
+    double m_dSoftLimit = 0;
+    std::function<void(double, bool)> m_fOnPressure;
+
+    mem_usage_tracker() = default;
 
 public:
-    mem_usage_tracker(int interval, double memUsageLimit,
-                      const std::string& fname, bool beSilent = false)
-        : m_iInterval(interval), m_dMemUsageLimit(memUsageLimit),
-          m_strFilePath(fname), m_bSilent(beSilent) {
-        stopFlag.store(false);
-        m_lCounter = 0;
-        startInSeparateThread();
+    static mem_usage_tracker& instance() {
+        static mem_usage_tracker tracker;
+        return tracker;
     }
 
     ~mem_usage_tracker() {
-        requestStopAndWait();
+        stop();
+    }
+
+    mem_usage_tracker(const mem_usage_tracker&) = delete;
+
+    mem_usage_tracker& operator=(const mem_usage_tracker&) = delete;
+
+    /**
+     * Starts sampling into `fname`, after stopping the previous run if any.
+     * @param memUsageLimit The hard limit on the virtual size, in GB.
+     */
+    void start(int interval, double memUsageLimit, const std::string& fname, bool beSilent = false) {
+        stop();
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        m_iInterval = interval;
+        m_dMemUsageLimit = memUsageLimit;
+        m_bSilent = beSilent;
+        m_lCounter = 0;
+        m_vOpenPhases.clear();
+        m_lOriginNs = monotonic_ns();
+        m_oFile = std::ofstream(fname);
+        if (!m_oFile.is_open()) {
+            std::cerr << "Failed to open the memory trace " << fname << std::endl;
+        }
+        m_oFile << "# mem_usage_tracker " << getDateTimeString() << "\n";
+        stopFlag.store(false);
+        m_oThread = std::thread(&mem_usage_tracker::trackMemoryUsage, this);
+    }
+
+    void stop() {
+        if (stopFlag.exchange(true)) {
+            return;
+        }
+        // std::exit() on the hard limit runs the destructor of the instance on the sampler thread itself, which is
+        // then left to exit on its own.
+        const bool self = onSamplerThread();
+        if (!self) {
+            m_oThread.join();
+        }
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (self) {
+            m_oThread.detach();
+        }
+        m_oFile.flush();
+        m_oFile.close();
+    }
+
+    bool running() const {
+        return !stopFlag.load();
+    }
+
+    /**
+     * Pushes the begin marker of a phase into the trace. The phases can be nested.
+     */
+    void phaseBegin(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (!running()) {
+            return;
+        }
+        const Sample s = takeSample();
+        writeSample('B', s, name);
+        m_vOpenPhases.push_back({name, s, s.rssGigs, s.inUseGigs});
+    }
+
+    /**
+     * Pushes the end marker of the innermost open phase named `name`, and its summary.
+     */
+    void phaseEnd(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_oMutex);
+        if (!running()) {
+            return;
+        }
+        const Sample s = takeSample();
+        writeSample('E', s, name);
+        updatePeaks(s);
+        for (auto it = m_vOpenPhases.rbegin(); it != m_vOpenPhases.rend(); ++it) {
+            if (it->name == name) {
+                m_oFile << "P," << name << "," << it->begin.tMs << "," << s.tMs << "," << it->begin.rssGigs << "," <<
+                    s.rssGigs << "," << it->rssPeak << "," << it->inUsePeak << "\n";
+                m_vOpenPhases.erase(std::next(it).base());
+                break;
+            }
+        }
+    }
+
+    /**
+     * Calls `onPressure(rssGigs, false)` from the sampler thread whenever a sample of the RSS is above `softLimitGigs`,
+     * and `onPressure(rssGigs, true)` when the hard limit is hit. The hard limit then waits up to m_iHardLimitGraceMs
+     * for the virtual size to drop under the limit before exiting, so the callback may just flag the pressure and leave
+     * the release to the thread that owns the memory (the RCPs of SymEngine can only be released from another thread
+     * with `WITH_SYMENGINE_THREAD_SAFE=ON`).
+     * The callback runs under a lock that `setSoftLimit()` and `clearSoftLimit()` also take, so it must not call them,
+     * and it is never running anymore once `clearSoftLimit()` returns.
+     */
+    void setSoftLimit(double softLimitGigs, std::function<void(double, bool)> onPressure) {
+        std::lock_guard<std::mutex> lock(m_oMutexPressure);
+        m_dSoftLimit = softLimitGigs;
+        m_fOnPressure = std::move(onPressure);
+    }
+
+    void clearSoftLimit() {
+        std::lock_guard<std::mutex> lock(m_oMutexPressure);
+        m_fOnPressure = nullptr;
+    }
+
+    static double getResidentUsage() {
+        double vmGigs, rssGigs;
+        readStatm(vmGigs, rssGigs);
+        return rssGigs;
     }
 
     std::string getDateTimeString() {
@@ -85,103 +227,103 @@ public:
         return dateTimeStr;
     }
 
-    void startInSeparateThread() {
-        try {
-            m_oFile = std::ofstream(m_strFilePath);
-            m_oThread = std::thread(&mem_usage_tracker::trackMemoryUsage, this);
-        }
-        catch (std::exception& e) {
-            std::cerr << "Error in StartInSeparateThread(): " << e.what() << std::endl;
+protected:
+    static bool& onSamplerThread() {
+        thread_local bool t_bSampler = false;
+        return t_bSampler;
+    }
+
+    /**
+     * Reads the virtual size and the RSS of the process from a single read of /proc/self/statm.
+     */
+    static void readStatm(double& vmGigs, double& rssGigs) {
+        vmGigs = rssGigs = -1;
+        if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+            unsigned long size = 0, resident = 0;
+            if (std::fscanf(f, "%lu %lu", &size, &resident) == 2) {
+                const double page = static_cast<double>(sysconf(_SC_PAGESIZE));
+                vmGigs = static_cast<double>(size) * page / 1073741824.0;
+                rssGigs = static_cast<double>(resident) * page / 1073741824.0;
+            }
+            std::fclose(f);
         }
     }
 
-    void requestStopAndWait() {
-        stopFlag.store(true);
-        m_oThread.join();
-        m_oFile.flush();
-        m_oFile.close();
-        // std::cout << "The memory tracker thread has stopped." << std::endl;
-        // std::cout << "The memory tracker file is saved at: " << m_strFilePath << std::endl;
+    Sample takeSample() const {
+        Sample s{};
+        s.tMs = static_cast<double>(monotonic_ns() - m_lOriginNs) / 1e6;
+        readStatm(s.vmGigs, s.rssGigs);
+        struct mallinfo2 mi = mallinfo2();
+        s.allocatedGigs = static_cast<double>(mi.arena) / 1073741824.0;
+        // The chunks served by mmap() are in use too, but are not counted by uordblks.
+        s.inUseGigs = static_cast<double>(mi.uordblks + mi.hblkhd) / 1073741824.0;
+        s.freeGigs = static_cast<double>(mi.fordblks) / 1073741824.0;
+        return s;
     }
 
-protected:
-    void writeToFileIfNeeded(std::string timeOfSample, double memUsage,
-                             std::map<std::string, double> dictDetailed) {
-        m_vPendingWrite.push_back(
-            {
-                memUsage, dictDetailed["totalAllocatedSpace"],
-                dictDetailed["totalInUseSpace"], dictDetailed["totalFreeSpace"],
-                dictDetailed["externalFragmentation"], timeOfSample.data()
-            });
-        if (m_vPendingWrite.size() % m_iFlushEvery == 0) {
-            m_oFile.flush();
+    void writeSample(char kind, const Sample& s, const std::string& name = "") {
+        m_oFile << kind << "," << s.tMs << "," << s.vmGigs << "," << s.rssGigs << "," << s.allocatedGigs << "," <<
+            s.inUseGigs << "," << s.freeGigs;
+        if (!name.empty()) {
+            m_oFile << "," << name;
         }
+        m_oFile << "\n";
+    }
 
-        if (m_vPendingWrite.size() >= m_iWriteEvery) {
-            for (auto& dataPoint : m_vPendingWrite) {
-                m_oFile << dataPoint.timeOfSample << "," <<
-                    dataPoint.memoryUsageInGB << "," <<
-                    dataPoint.totalAllocatedSpace << "," <<
-                    dataPoint.totalInUseSpace << "," <<
-                    dataPoint.totalFreeSpace << "," <<
-                    dataPoint.externalFragmentation << std::endl;
-            }
-            m_vPendingWrite.clear();
+    void updatePeaks(const Sample& s) {
+        for (auto& p : m_vOpenPhases) {
+            p.rssPeak = std::max(p.rssPeak, s.rssGigs);
+            p.inUsePeak = std::max(p.inUsePeak, s.inUseGigs);
         }
     }
 
     // Function to be run in a separate thread
     void trackMemoryUsage() {
+        onSamplerThread() = true;
         while (!stopFlag.load()) {
-            auto usageGigs = getMemoryUsage();
-            auto dictDetailed = getMemoryUsageDetailed();
+            Sample s = takeSample();
             if (m_lCounter++ % 5 == 0 && !m_bSilent) {
                 std::cerr << "######################  Current memory usage: " << std::fixed
-                    << std::setprecision(2) << usageGigs << " GB, Allocated: "
+                    << std::setprecision(2) << s.vmGigs << " GB, RSS: "
                     << std::fixed << std::setprecision(2)
-                    << dictDetailed["totalAllocatedSpace"] << " GB, In-use: "
+                    << s.rssGigs << " GB, Allocated: "
                     << std::fixed << std::setprecision(2)
-                    << dictDetailed["totalInUseSpace"] << " GB, Ext-fragmantation: "
+                    << s.allocatedGigs << " GB, In-use: "
                     << std::fixed << std::setprecision(2)
-                    << dictDetailed["externalFragmentation"] << "  ****"
+                    << s.inUseGigs << " GB  ****"
                     << std::endl;
             }
-            if (usageGigs > m_dMemUsageLimit) {
+            bool owned = false;
+            {
+                std::lock_guard<std::mutex> lock(m_oMutexPressure);
+                if (m_fOnPressure) {
+                    owned = true;
+                    const bool hardLimit = s.vmGigs > m_dMemUsageLimit;
+                    if (hardLimit || s.rssGigs > m_dSoftLimit) {
+                        m_fOnPressure(s.rssGigs, hardLimit);
+                        s = takeSample();
+                    }
+                }
+            }
+            // The owner may release the memory on its own thread, after the callback has returned.
+            const uint64_t deadline = monotonic_ns() + static_cast<uint64_t>(m_iHardLimitGraceMs) * 1000000ull;
+            while (owned && s.vmGigs > m_dMemUsageLimit && monotonic_ns() < deadline && !stopFlag.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::min(m_iInterval, 10)));
+                s = takeSample();
+            }
+            if (s.vmGigs > m_dMemUsageLimit) {
                 std::cerr << "Memory usage is too high! Exiting..." << std::endl;
                 std::exit(99);
             }
-            std::cerr.flush();
-            writeToFileIfNeeded(getDateTimeString(), usageGigs, dictDetailed);
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_iInterval));
-        }
-        // std::cout << "Memory tracker thread is exiting..." << std::endl;
-    }
-
-protected:
-    // Function to get the current memory usage in KB
-    double getMemoryUsage() {
-        std::ifstream procStatus("/proc/self/status");
-        std::string line;
-        while (std::getline(procStatus, line)) {
-            if (line.substr(0, 6) == "VmSize") {
-                long memoryUsageKB = std::stol(
-                    line.substr(line.find_last_of('\t'), line.find_last_of('k') - 1));
-                return static_cast<double>(memoryUsageKB) /
-                    1048576.0; // Convert KB to GB
+            {
+                std::lock_guard<std::mutex> lock(m_oMutex);
+                writeSample('S', s);
+                updatePeaks(s);
+                if (m_lCounter % m_iFlushEvery == 0) {
+                    m_oFile.flush();
+                }
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_iInterval));
         }
-        return -1; // Return -1 if VmSize line is not found
-    }
-
-    std::map<std::string, double> getMemoryUsageDetailed() {
-        std::map<std::string, double> memUsage;
-        struct mallinfo2 mi = mallinfo2();
-        memUsage["totalAllocatedSpace"] = (double)mi.arena / 1024.0 / 1024.0 / 1024.0;
-        memUsage["totalInUseSpace"] = mi.uordblks / 1024.0 / 1024.0 / 1024.0;
-        memUsage["totalFreeSpace"] = mi.fordblks / 1024.0 / 1024.0 / 1024.0;
-        memUsage["largestAllocatableBlock"] = mi.hblkhd / 1024.0 / 1024.0 / 1024.0;
-        memUsage["externalFragmentation"] =
-            1.0 - static_cast<double>(mi.hblkhd) / static_cast<double>(mi.fordblks);
-        return memUsage;
     }
 };
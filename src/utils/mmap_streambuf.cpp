@@ -0,0 +1,139 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "mmap_streambuf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    size_t page_size() {
+        static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    std::runtime_error sys_error(const std::string &what) {
+        return std::runtime_error("mmap_streambuf: " + what + ": " + strerror(errno));
+    }
+}
+
+mmap_streambuf::mmap_streambuf(const std::string &path, size_t size_hint, size_t release_bytes) :
+    m_lReleaseBytes(std::max(page_size(), release_bytes)) {
+    m_iFd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_iFd < 0) {
+        throw sys_error("cannot open " + path);
+    }
+    m_lCapacity = std::max(page_size(), size_hint);
+    if (ftruncate(m_iFd, static_cast<off_t>(m_lCapacity)) != 0) {
+        const auto e = sys_error("cannot size " + path);
+        ::close(m_iFd);
+        throw e;
+    }
+    void *p = mmap(nullptr, m_lCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_iFd, 0);
+    if (p == MAP_FAILED) {
+        const auto e = sys_error("cannot map " + path);
+        ::close(m_iFd);
+        throw e;
+    }
+    m_pBase = static_cast<char*>(p);
+    setp(m_pBase, m_pBase + m_lCapacity);
+}
+
+mmap_streambuf::~mmap_streambuf() {
+    try {
+        close();
+    } catch (const std::exception &e) {
+        std::cout << "mmap_streambuf: Error in destructor: " << e.what() << std::endl;
+    }
+}
+
+void mmap_streambuf::grow(size_t needed) {
+    const size_t used = size();
+    size_t capacity = m_lCapacity;
+    while (capacity - used < needed) {
+        capacity *= 2;
+    }
+    if (ftruncate(m_iFd, static_cast<off_t>(capacity)) != 0) {
+        throw sys_error("cannot grow the file");
+    }
+    void *p = mremap(m_pBase, m_lCapacity, capacity, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) {
+        throw sys_error("cannot remap the file");
+    }
+    m_pBase = static_cast<char*>(p);
+    m_lCapacity = capacity;
+    setp(m_pBase, m_pBase + m_lCapacity);
+    advance(used);
+}
+
+void mmap_streambuf::advance(size_t bytes) {
+    // pbump() takes an int, which a file of more than 2 GiB does not fit in.
+    while (bytes > 0) {
+        const size_t step = std::min<size_t>(bytes, std::numeric_limits<int>::max());
+        pbump(static_cast<int>(step));
+        bytes -= step;
+    }
+}
+
+void mmap_streambuf::release_filled() {
+    const size_t filled = size() / page_size() * page_size();
+    if (filled - m_lReleased >= m_lReleaseBytes) {
+        // Starts the write-back, then drops the pages from the mapping; their contents stay in the page cache.
+        msync(m_pBase + m_lReleased, filled - m_lReleased, MS_ASYNC);
+        madvise(m_pBase + m_lReleased, filled - m_lReleased, MADV_DONTNEED);
+        m_lReleased = filled;
+    }
+}
+
+mmap_streambuf::int_type mmap_streambuf::overflow(int_type ch) {
+    if (m_pBase == nullptr) {
+        return traits_type::eof();
+    }
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    const char c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize mmap_streambuf::xsputn(const char *s, std::streamsize n) {
+    if (m_pBase == nullptr || n <= 0) {
+        return 0;
+    }
+    // An error of grow() propagates to the writer as a runtime_error: cereal writes through rdbuf()->sputn(), so no
+    // ostream is in between to turn it into its badbit.
+    const auto bytes = static_cast<size_t>(n);
+    if (static_cast<size_t>(epptr() - pptr()) < bytes) {
+        grow(bytes);
+    }
+    std::memcpy(pptr(), s, bytes);
+    advance(bytes);
+    release_filled();
+    return n;
+}
+
+void mmap_streambuf::close() {
+    if (m_pBase == nullptr) {
+        return;
+    }
+    const size_t used = size();
+    munmap(m_pBase, m_lCapacity);
+    m_pBase = nullptr;
+    setp(nullptr, nullptr);
+    const int truncated = ftruncate(m_iFd, static_cast<off_t>(used));
+    const int saved = errno;
+    ::close(m_iFd);
+    m_iFd = -1;
+    if (truncated != 0) {
+        errno = saved;
+        throw sys_error("cannot truncate the file");
+    }
+}
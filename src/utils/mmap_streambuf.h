@@ -0,0 +1,68 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+/**
+ * An output streambuf that writes straight into a shared mapping of a file, so a serializer writing to an
+ * `std::ostream` over it copies its bytes into the page cache once, with no intermediate `std::string`.
+ *
+ * The file is pre-sized to `size_hint` bytes and mapped; when the writes run past the mapping, the file is doubled and
+ * remapped (mremap). Every `release_bytes` written, the pages already filled are handed back with
+ * madvise(MADV_DONTNEED): they stay dirty in the page cache and are written back by the kernel, but they leave the
+ * resident set of the process, so saving a large expr does not grow the RSS by its size. `close()` (or the
+ * destructor) unmaps the file and truncates it to the bytes written. If the file cannot be grown, the write throws a
+ * `std::runtime_error` out of the serializer (e.g. `dump_to()`), it does not only set the badbit of the ostream.
+ *
+ * Usage:
+ *  mmap_streambuf buf("expr.bin", expected_size);
+ *  std::ostream os(&buf);
+ *  dump_to(os, expr);
+ *  buf.close();
+ */
+class mmap_streambuf : public std::streambuf {
+private:
+    int m_iFd = -1;
+    char *m_pBase = nullptr;
+    size_t m_lCapacity = 0;
+    // The bytes at the front of the mapping that were already handed back to the kernel.
+    size_t m_lReleased = 0;
+    const size_t m_lReleaseBytes;
+
+    void grow(size_t needed);
+
+    void advance(size_t bytes);
+
+    void release_filled();
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+public:
+    explicit mmap_streambuf(const std::string &path, size_t size_hint = 64 << 20, size_t release_bytes = 64 << 20);
+
+    ~mmap_streambuf() override;
+
+    mmap_streambuf(const mmap_streambuf&) = delete;
+
+    mmap_streambuf& operator=(const mmap_streambuf&) = delete;
+
+    /**
+     * @return The number of bytes written so far.
+     */
+    size_t size() const {
+        return m_pBase == nullptr ? 0 : static_cast<size_t>(pptr() - m_pBase);
+    }
+
+    /**
+     * Unmaps the file and truncates it to the bytes written. Throws std::runtime_error if the truncation fails.
+     */
+    void close();
+};
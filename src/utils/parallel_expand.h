@@ -0,0 +1,119 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <symengine/symengine_config.h>
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/expand.h>
+#include <symengine/constants.h>
+
+/**
+ * `SymEngine::expand()` of a sum expands its terms one after the other. The terms of the sums of powers of this repo
+ * are independent, so `parallel_expand()` expands them on a pool of workers instead:
+ *  - The workers grab chunks of terms and accumulate the expanded monomials into their own (coef, dict) partial sum,
+ *    so they do not share anything while expanding.
+ *  - The partial sums are merged with a tree reduction, log2(threads) rounds of pairwise merges running in parallel.
+ *  - The result is canonicalized once through `Add::from_dict`.
+ *
+ * The workers create and drop references to the shared nodes (the symbols, the constants), which is only safe when
+ * SymEngine is built with atomic reference counts (`WITH_SYMENGINE_THREAD_SAFE=ON`). Otherwise it falls back to
+ * `SymEngine::expand()`.
+ */
+namespace parallel_expand_detail {
+    struct partial_sum {
+        SymEngine::RCP<const SymEngine::Number> coef = SymEngine::zero;
+        SymEngine::umap_basic_num dict;
+
+        void add(const SymEngine::RCP<const SymEngine::Basic> &e) {
+            if (SymEngine::is_a<SymEngine::Add>(*e)) {
+                const auto &a = SymEngine::down_cast<const SymEngine::Add &>(*e);
+                SymEngine::iaddnum(SymEngine::outArg(coef), a.get_coef());
+                for (const auto &[term, c] : a.get_dict()) {
+                    SymEngine::Add::dict_add_term(dict, c, term);
+                }
+            } else {
+                SymEngine::Add::coef_dict_add_term(SymEngine::outArg(coef), dict, e);
+            }
+        }
+
+        /**
+         * Moves `other` into this partial sum, iterating over the smaller of the two dicts.
+         */
+        void merge(partial_sum &other) {
+            if (other.dict.size() > dict.size()) {
+                std::swap(dict, other.dict);
+            }
+            SymEngine::iaddnum(SymEngine::outArg(coef), other.coef);
+            for (const auto &[term, c] : other.dict) {
+                SymEngine::Add::dict_add_term(dict, c, term);
+            }
+            other.dict = SymEngine::umap_basic_num();
+        }
+    };
+}
+
+/**
+ * @param threads The number of workers, all the hardware threads if 0.
+ */
+inline SymEngine::RCP<const SymEngine::Basic> parallel_expand(const SymEngine::RCP<const SymEngine::Basic> &expr,
+                                                               size_t threads = 0) {
+#ifndef WITH_SYMENGINE_THREAD_SAFE
+    static bool s_bWarned = false;
+    if (!s_bWarned) {
+        s_bWarned = true;
+        std::cout << "parallel_expand: SymEngine is not built with WITH_SYMENGINE_THREAD_SAFE, expanding serially." <<
+            std::endl;
+    }
+    threads = 1;
+#endif
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || !SymEngine::is_a<SymEngine::Add>(*expr)) {
+        return SymEngine::expand(expr);
+    }
+
+    const auto terms = expr->get_args();
+    constexpr size_t CHUNK = 16;
+    threads = std::min(threads, (terms.size() + CHUNK - 1) / CHUNK);
+    std::vector<parallel_expand_detail::partial_sum> parts(threads);
+    std::atomic<size_t> next{0};
+    {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                auto &part = parts[t];
+                for (size_t first = next.fetch_add(CHUNK); first < terms.size(); first = next.fetch_add(CHUNK)) {
+                    for (size_t i = first; i < std::min(first + CHUNK, terms.size()); i++) {
+                        part.add(SymEngine::expand(terms[i]));
+                    }
+                }
+            });
+        }
+        for (auto &w : workers) {
+            w.join();
+        }
+    }
+
+    for (size_t stride = 1; stride < parts.size(); stride *= 2) {
+        std::vector<std::thread> mergers;
+        for (size_t i = 0; i + stride < parts.size(); i += 2 * stride) {
+            mergers.emplace_back([&parts, i, stride]() {
+                parts[i].merge(parts[i + stride]);
+            });
+        }
+        for (auto &m : mergers) {
+            m.join();
+        }
+    }
+    return SymEngine::Add::from_dict(parts[0].coef, std::move(parts[0].dict));
+}
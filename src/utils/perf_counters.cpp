@@ -0,0 +1,190 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "perf_counters.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    long sys_perf_event_open(perf_event_attr* attr, pid_t pid, int cpu, int group_fd, unsigned long flags) {
+        return syscall(SYS_perf_event_open, attr, pid, cpu, group_fd, flags);
+    }
+
+    uint64_t cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+        return cache | (op << 8) | (result << 16);
+    }
+
+    void describe(perf_counters::event_id id, perf_event_attr& attr) {
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch (id) {
+            case perf_counters::CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case perf_counters::INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case perf_counters::BRANCH_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case perf_counters::L1D_READ_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case perf_counters::LLC_READ_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_config(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case perf_counters::DTLB_READ_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            default:
+                break;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+
+    // Only complain once per process, benches open a lot of scopes.
+    std::atomic<bool> s_bWarned{false};
+
+    void warn_once(perf_counters::event_id id, int err) {
+        if (s_bWarned.exchange(true)) {
+            return;
+        }
+        std::cerr << "perf_counters: cannot open " << perf_counters::event_name(id) << ": " << std::strerror(err);
+        if (err == EACCES || err == EPERM) {
+            std::cerr << " (check /proc/sys/kernel/perf_event_paranoid or CAP_PERFMON)";
+        }
+        std::cerr << ". The unavailable counters will be skipped." << std::endl;
+    }
+}
+
+const char* perf_counters::event_name(event_id id) {
+    switch (id) {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case BRANCH_MISSES: return "branch-misses";
+        case L1D_READ_MISSES: return "L1D-read-misses";
+        case LLC_READ_MISSES: return "LLC-read-misses";
+        case DTLB_READ_MISSES: return "dTLB-read-misses";
+        default: return "unknown";
+    }
+}
+
+perf_counters::perf_counters() {
+    open_group({CYCLES, INSTRUCTIONS, BRANCH_MISSES});
+    open_group({L1D_READ_MISSES, LLC_READ_MISSES, DTLB_READ_MISSES});
+}
+
+perf_counters::~perf_counters() {
+    for (auto &g : m_vGroups) {
+        for (int fd : g.fds) {
+            close(fd);
+        }
+    }
+}
+
+void perf_counters::open_group(const std::vector<event_id>& events) {
+    group g;
+    for (auto id : events) {
+        perf_event_attr attr;
+        describe(id, attr);
+        // Only the leader starts disabled; the members follow it.
+        attr.disabled = g.leader_fd == -1 ? 1 : 0;
+        int fd = static_cast<int>(sys_perf_event_open(&attr, 0, -1, g.leader_fd, 0));
+        if (fd == -1) {
+            warn_once(id, errno);
+            continue;
+        }
+        if (g.leader_fd == -1) {
+            g.leader_fd = fd;
+        }
+        g.fds.push_back(fd);
+        g.events.push_back(id);
+    }
+    if (g.leader_fd != -1) {
+        m_vGroups.push_back(std::move(g));
+    }
+}
+
+void perf_counters::start() {
+    for (auto &g : m_vGroups) {
+        ioctl(g.leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(g.leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+perf_counters::reading perf_counters::stop() {
+    reading r;
+    for (auto &g : m_vGroups) {
+        ioctl(g.leader_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+    for (auto &g : m_vGroups) {
+        // {nr, time_enabled, time_running, value[nr]}
+        std::vector<uint64_t> buf(3 + g.fds.size());
+        const auto bytes = read(g.leader_fd, buf.data(), buf.size() * sizeof(uint64_t));
+        if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buf[0] != g.fds.size()) {
+            continue;
+        }
+        const uint64_t enabled = buf[1];
+        const uint64_t running = buf[2];
+        if (running == 0) {
+            // The group never got scheduled on the PMU.
+            continue;
+        }
+        const double scale = static_cast<double>(enabled) / static_cast<double>(running);
+        for (size_t i = 0; i < g.fds.size(); i++) {
+            r.values[g.events[i]] = static_cast<uint64_t>(static_cast<double>(buf[3 + i]) * scale);
+            r.valid[g.events[i]] = true;
+        }
+    }
+    return r;
+}
+
+perf_scope::~perf_scope() {
+    if (!m_oCounters.available()) {
+        return;
+    }
+    auto r = m_oCounters.stop();
+    std::cout << "============================================" << std::endl;
+    std::cout << "Perf counters for " << name << " :" << std::endl;
+    for (int i = 0; i < perf_counters::EVENT_COUNT; i++) {
+        auto id = static_cast<perf_counters::event_id>(i);
+        std::cout << "> " << std::left << std::setw(18) << perf_counters::event_name(id) << "\t";
+        if (!r.valid[id]) {
+            std::cout << "n/a" << std::endl;
+            continue;
+        }
+        std::cout << r.values[id];
+        if (m_lUnits != 0 && id != perf_counters::CYCLES && id != perf_counters::INSTRUCTIONS) {
+            std::cout << "\t(" << static_cast<double>(r.values[id]) / static_cast<double>(m_lUnits) << " per " <<
+                m_sUnitName << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "> IPC:              \t" << r.ipc() << std::endl;
+    if (m_lUnits != 0 && r.valid[perf_counters::CYCLES]) {
+        std::cout << "> Cycles per " << m_sUnitName << ":\t" <<
+            static_cast<double>(r.values[perf_counters::CYCLES]) / static_cast<double>(m_lUnits) << std::endl;
+    }
+    std::cout << std::right << "============================================" << std::endl;
+}
@@ -0,0 +1,102 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Hardware performance counters of the calling thread, read through perf_event_open(2).
+ * The events are opened as two groups, {cycles, instructions, branch-misses} and {L1D read misses, LLC read misses,
+ * dTLB read misses}, so each group fits in the PMU at once; if the kernel multiplexes them anyway, the counts are
+ * scaled by time_enabled/time_running.
+ *
+ * Opening the counters can fail (perf_event_paranoid, containers without CAP_PERFMON, VMs without a virtual PMU, ...).
+ * In that case the unavailable events are reported as such and everything else keeps working; if nothing can be
+ * opened the instance is a no-op.
+ */
+class perf_counters {
+public:
+    enum event_id {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_READ_MISSES,
+        LLC_READ_MISSES,
+        DTLB_READ_MISSES,
+        EVENT_COUNT
+    };
+
+    struct reading {
+        std::array<uint64_t, EVENT_COUNT> values{};
+        std::array<bool, EVENT_COUNT> valid{};
+
+        double ipc() const {
+            if (!valid[CYCLES] || !valid[INSTRUCTIONS] || values[CYCLES] == 0) {
+                return 0;
+            }
+            return static_cast<double>(values[INSTRUCTIONS]) / static_cast<double>(values[CYCLES]);
+        }
+    };
+
+private:
+    struct group {
+        int leader_fd = -1;
+        std::vector<int> fds;            // leader first
+        std::vector<event_id> events;    // in the same order as fds
+    };
+
+    std::vector<group> m_vGroups;
+
+    void open_group(const std::vector<event_id>& events);
+
+public:
+    perf_counters();
+
+    ~perf_counters();
+
+    perf_counters(const perf_counters&) = delete;
+
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available() const {
+        return !m_vGroups.empty();
+    }
+
+    void start();
+
+    reading stop();
+
+    static const char* event_name(event_id id);
+};
+
+/**
+ * RAII helper in the spirit of `timer_scope`: counts the enclosed region on the calling thread and prints the counters,
+ * the IPC and the misses per unit of work (e.g. per expression node) on destruction.
+ */
+class perf_scope {
+private:
+    const std::string name;
+    perf_counters m_oCounters;
+    size_t m_lUnits = 0;
+    std::string m_sUnitName = "node";
+
+public:
+    explicit perf_scope(const std::string& name) : name(name) {
+        m_oCounters.start();
+    }
+
+    /**
+     * Sets the amount of work done in the scope, used to report the misses per unit. Can be called at any point.
+     */
+    void set_units(size_t units, const std::string& unitName = "node") {
+        m_lUnits = units;
+        m_sUnitName = unitName;
+    }
+
+    ~perf_scope();
+};
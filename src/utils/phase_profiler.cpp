@@ -0,0 +1,117 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#include "phase_profiler.h"
+#include "timers.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+    std::string escape_json(const std::string& s) {
+        std::string result;
+        result.reserve(s.size());
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result;
+    }
+
+    double to_mb(uint64_t bytes) {
+        return static_cast<double>(bytes) / 1048576.0;
+    }
+}
+
+phase_profiler::phase_profiler() : m_lOriginNs(monotonic_ns()) {
+}
+
+phase_profiler& phase_profiler::instance() {
+    static phase_profiler s_oInstance;
+    return s_oInstance;
+}
+
+phase_profiler::memory_counters phase_profiler::read_memory_counters() {
+    memory_counters mem{0, 0};
+    // statm: size resident shared text lib data dt, in pages.
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        unsigned long size = 0, resident = 0;
+        if (std::fscanf(f, "%lu %lu", &size, &resident) == 2) {
+            mem.rss_bytes = static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        }
+        std::fclose(f);
+    }
+    struct mallinfo2 mi = mallinfo2();
+    mem.heap_in_use_bytes = mi.uordblks + mi.hblkhd;
+    return mem;
+}
+
+phase_profiler::thread_buffer& phase_profiler::local_buffer() {
+    // Buffers are owned by the profiler and outlive their threads, so the cached pointer stays valid.
+    thread_local thread_buffer* t_pBuffer = nullptr;
+    if (t_pBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(m_oMutexBuffers);
+        m_vBuffers.push_back(std::make_unique<thread_buffer>(static_cast<uint32_t>(syscall(SYS_gettid))));
+        t_pBuffer = m_vBuffers.back().get();
+    }
+    return *t_pBuffer;
+}
+
+void phase_profiler::record(char type, const std::string& name) {
+    auto mem = read_memory_counters();
+    local_buffer().events.push_back({type, monotonic_ns() - m_lOriginNs, mem, name});
+}
+
+void phase_profiler::write_chrome_trace(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_oMutexBuffers);
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open the trace file " << path << std::endl;
+        return;
+    }
+    const auto pid = static_cast<long>(getpid());
+    bool first = true;
+    auto sep = [&]() {
+        file << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (auto &buf : m_vBuffers) {
+        sep();
+        file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << buf->tid <<
+            ", \"args\": {\"name\": \"thread " << buf->tid << "\"}}";
+        for (auto &e : buf->events) {
+            const double ts_us = static_cast<double>(e.ts_ns) / 1000.0;
+            if (e.type != 'C') {
+                sep();
+                file << "{\"name\": \"" << escape_json(e.name) << "\", \"cat\": \"phase\", \"ph\": \"" << e.type <<
+                    "\", \"ts\": " << std::fixed << ts_us << ", \"pid\": " << pid << ", \"tid\": " << buf->tid <<
+                    ", \"args\": {\"rss_mb\": " << to_mb(e.mem.rss_bytes) << ", \"heap_in_use_mb\": " <<
+                    to_mb(e.mem.heap_in_use_bytes) << "}}";
+            }
+            // Every event also feeds the process-wide counter tracks.
+            sep();
+            file << "{\"name\": \"memory (MB)\", \"ph\": \"C\", \"ts\": " << std::fixed << ts_us << ", \"pid\": " <<
+                pid << ", \"args\": {\"rss\": " << to_mb(e.mem.rss_bytes) << ", \"heap_in_use\": " <<
+                to_mb(e.mem.heap_in_use_bytes) << "}}";
+        }
+    }
+    file << "\n]}\n";
+    file.close();
+    std::cout << "The phase trace is saved at: " << path << std::endl;
+}
+
+void phase_profiler::clear() {
+    std::lock_guard<std::mutex> lock(m_oMutexBuffers);
+    for (auto &buf : m_vBuffers) {
+        buf->events.clear();
+    }
+}
@@ -0,0 +1,121 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * A process-wide, nested phase profiler that exports Chrome trace-event JSON (loadable in chrome://tracing and
+ * Perfetto).
+ * Every thread appends its begin/end events to its own buffer, so recording never takes a lock; the registry mutex is
+ * only used the first time a thread records and when the trace is written.
+ * Each begin/end event is annotated with the RSS and the malloc in-use bytes of the process, which are also emitted as
+ * counter tracks so the timeline shows the memory curve next to the phases.
+ *
+ * Recording is off until `enable()` is called. `write_chrome_trace()` must be called once the recording threads are
+ * idle.
+ */
+class phase_profiler {
+public:
+    struct memory_counters {
+        uint64_t rss_bytes;
+        uint64_t heap_in_use_bytes;
+    };
+
+private:
+    struct event {
+        char type; // 'B', 'E' or 'C', as in the trace-event format.
+        uint64_t ts_ns;
+        memory_counters mem;
+        std::string name;
+    };
+
+    struct thread_buffer {
+        const uint32_t tid;
+        std::vector<event> events;
+
+        explicit thread_buffer(uint32_t tid) : tid(tid) {
+        }
+    };
+
+    std::atomic<bool> m_bEnabled{false};
+    const uint64_t m_lOriginNs;
+    std::mutex m_oMutexBuffers;
+    std::vector<std::unique_ptr<thread_buffer>> m_vBuffers;
+
+    phase_profiler();
+
+    thread_buffer& local_buffer();
+
+    void record(char type, const std::string& name);
+
+public:
+    static phase_profiler& instance();
+
+    static memory_counters read_memory_counters();
+
+    void enable() {
+        m_bEnabled.store(true);
+    }
+
+    void disable() {
+        m_bEnabled.store(false);
+    }
+
+    bool enabled() const {
+        return m_bEnabled.load(std::memory_order_relaxed);
+    }
+
+    void begin(const std::string& name) {
+        if (enabled()) {
+            record('B', name);
+        }
+    }
+
+    void end(const std::string& name) {
+        if (enabled()) {
+            record('E', name);
+        }
+    }
+
+    /**
+     * Adds a sample to the memory counter tracks without opening a phase.
+     */
+    void sample_memory() {
+        if (enabled()) {
+            record('C', "memory");
+        }
+    }
+
+    void write_chrome_trace(const std::string& path);
+
+    void clear();
+};
+
+/**
+ * RAII helper that opens a named phase on the current thread and closes it on destruction. Scopes nest.
+ */
+class phase_scope {
+private:
+    const std::string name;
+
+public:
+    explicit phase_scope(const std::string& name) : name(name) {
+        phase_profiler::instance().begin(name);
+    }
+
+    phase_scope(const phase_scope&) = delete;
+
+    phase_scope& operator=(const phase_scope&) = delete;
+
+    ~phase_scope() {
+        phase_profiler::instance().end(name);
+    }
+};
@@ -0,0 +1,236 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/pow.h>
+#include <symengine/symbol.h>
+#include <symengine/integer.h>
+#include <symengine/constants.h>
+#include "utils/varint_codec.h"
+
+/**
+ * A storage format for polynomial-shaped exprs, such as the expanded sums of powers of bench01.
+ * An expanded `(a + b + c)^p` is a huge Add of monomials, each one a Mul holding a map of symbol -> Integer. Through
+ * `Basic::dumps()` every monomial is a full node with its own map and exponent nodes. `dumps_poly()` stores the same
+ * expr as:
+ *
+ *  "SPC1" | symbol table | constant | coefficients[terms] | exponent matrix (CSR: nnz, then (symbol, exponent) pairs)
+ *
+ * The integers and the coefficients are encoded as in `utils/varint_codec.h`. `loads_poly()` rebuilds the Add in one
+ * pass through `Add::from_dict`, sharing the `symbol^exponent` nodes between the monomials.
+ *
+ * Only sums of Integer multiples of monomials with positive Integer exponents are supported; `is_polynomial()` tells
+ * whether an expr can be stored this way, `dumps_poly()` throws otherwise.
+ */
+namespace poly_detail {
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    using codec::put_varint;
+    using codec::get_varint;
+    using codec::put_integer;
+    using codec::get_integer;
+
+    inline bool is_exponent(const SymEngine::Basic &e) {
+        if (!SymEngine::is_a<SymEngine::Integer>(e)) {
+            return false;
+        }
+        const auto &i = SymEngine::down_cast<const SymEngine::Integer &>(e).as_integer_class();
+        return SymEngine::mp_fits_slong_p(i) && SymEngine::mp_get_si(i) > 0;
+    }
+
+    /**
+     * Calls `fn(coef, dict)` with the Integer coefficient and the symbol -> exponent factors of a monomial, or returns
+     * false if `x` is not one.
+     */
+    template<typename Fn>
+    bool visit_monomial(const rcp_basic &x, const SymEngine::RCP<const SymEngine::Number> &coef, Fn &&fn) {
+        if (!SymEngine::is_a<SymEngine::Integer>(*coef)) {
+            return false;
+        }
+        if (SymEngine::is_a<SymEngine::Symbol>(*x)) {
+            SymEngine::map_basic_basic d;
+            d[x] = SymEngine::one;
+            fn(*coef, d);
+            return true;
+        }
+        if (SymEngine::is_a<SymEngine::Pow>(*x)) {
+            const auto &p = SymEngine::down_cast<const SymEngine::Pow &>(*x);
+            if (!SymEngine::is_a<SymEngine::Symbol>(*p.get_base()) || !is_exponent(*p.get_exp())) {
+                return false;
+            }
+            SymEngine::map_basic_basic d;
+            d[p.get_base()] = p.get_exp();
+            fn(*coef, d);
+            return true;
+        }
+        if (SymEngine::is_a<SymEngine::Mul>(*x)) {
+            const auto &m = SymEngine::down_cast<const SymEngine::Mul &>(*x);
+            if (!SymEngine::is_a<SymEngine::Integer>(*m.get_coef())) {
+                return false;
+            }
+            for (const auto &[base, exp] : m.get_dict()) {
+                if (!SymEngine::is_a<SymEngine::Symbol>(*base) || !is_exponent(*exp)) {
+                    return false;
+                }
+            }
+            fn(*SymEngine::mulnum(coef, m.get_coef()), m.get_dict());
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Calls `fn(coef, dict)` for every monomial of `expr` and `constant(c)` for its constant term.
+     */
+    template<typename Fn, typename ConstFn>
+    bool visit_polynomial(const rcp_basic &expr, Fn &&fn, ConstFn &&constant) {
+        if (SymEngine::is_a<SymEngine::Integer>(*expr)) {
+            constant(SymEngine::down_cast<const SymEngine::Integer &>(*expr));
+            return true;
+        }
+        if (!SymEngine::is_a<SymEngine::Add>(*expr)) {
+            constant(*SymEngine::zero);
+            return visit_monomial(expr, SymEngine::one, fn);
+        }
+        const auto &a = SymEngine::down_cast<const SymEngine::Add &>(*expr);
+        if (!SymEngine::is_a<SymEngine::Integer>(*a.get_coef())) {
+            return false;
+        }
+        constant(SymEngine::down_cast<const SymEngine::Integer &>(*a.get_coef()));
+        for (const auto &[term, coef] : a.get_dict()) {
+            if (!visit_monomial(term, coef, fn)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+inline bool is_polynomial(const SymEngine::RCP<const SymEngine::Basic> &expr) {
+    return poly_detail::visit_polynomial(expr, [](const SymEngine::Basic &, const SymEngine::map_basic_basic &) {},
+                                         [](const SymEngine::Basic &) {});
+}
+
+inline std::string dumps_poly(const SymEngine::RCP<const SymEngine::Basic> &expr) {
+    using namespace poly_detail;
+    std::unordered_map<rcp_basic, uint64_t, SymEngine::RCPBasicHash, SymEngine::RCPBasicKeyEq> symIds;
+    std::vector<std::string> symNames;
+    std::string constant, coefs, matrix;
+    uint64_t terms = 0;
+
+    const bool ok = visit_polynomial(expr, [&](const SymEngine::Basic &coef, const SymEngine::map_basic_basic &d) {
+        put_integer(coefs, SymEngine::down_cast<const SymEngine::Integer &>(coef));
+        put_varint(matrix, d.size());
+        for (const auto &[sym, exp] : d) {
+            auto it = symIds.find(sym);
+            if (it == symIds.end()) {
+                it = symIds.emplace(sym, symNames.size()).first;
+                symNames.push_back(SymEngine::down_cast<const SymEngine::Symbol &>(*sym).get_name());
+            }
+            put_varint(matrix, it->second);
+            put_varint(matrix, static_cast<uint64_t>(
+                SymEngine::mp_get_si(SymEngine::down_cast<const SymEngine::Integer &>(*exp).as_integer_class())));
+        }
+        terms++;
+    }, [&](const SymEngine::Basic &c) {
+        put_integer(constant, SymEngine::down_cast<const SymEngine::Integer &>(c));
+    });
+    if (!ok) {
+        throw std::runtime_error("The expr is not a polynomial with Integer coefficients");
+    }
+
+    std::string out = "SPC1";
+    put_varint(out, symNames.size());
+    for (const auto &name : symNames) {
+        codec::put_string(out, name);
+    }
+    out += constant;
+    put_varint(out, terms);
+    out += coefs;
+    out += matrix;
+    return out;
+}
+
+inline SymEngine::RCP<const SymEngine::Basic> loads_poly(const std::string &data) {
+    using namespace poly_detail;
+    if (data.compare(0, 4, "SPC1") != 0) {
+        throw std::runtime_error("Not a sparse polynomial");
+    }
+    size_t pos = 4;
+    std::vector<rcp_basic> syms(get_varint(data, pos));
+    for (auto &s : syms) {
+        s = SymEngine::symbol(codec::get_string(data, pos));
+    }
+    SymEngine::RCP<const SymEngine::Number> constant = get_integer(data, pos);
+    std::vector<SymEngine::RCP<const SymEngine::Number>> coefs(get_varint(data, pos));
+    for (auto &c : coefs) {
+        c = get_integer(data, pos);
+    }
+
+    // The small exponents and the symbol^exponent nodes are shared by all the monomials.
+    constexpr uint64_t SHARED_EXPONENTS = 256;
+    std::vector<rcp_basic> exps(SHARED_EXPONENTS);
+    std::vector<std::vector<rcp_basic>> powers(syms.size());
+    auto exponent = [&](uint64_t e) -> rcp_basic {
+        if (e >= SHARED_EXPONENTS) {
+            return SymEngine::integer(static_cast<long>(e));
+        }
+        if (exps[e].is_null()) {
+            exps[e] = SymEngine::integer(static_cast<long>(e));
+        }
+        return exps[e];
+    };
+    auto power = [&](uint64_t s, uint64_t e) -> rcp_basic {
+        if (e == 1) {
+            return syms[s];
+        }
+        if (e >= SHARED_EXPONENTS) {
+            return SymEngine::make_rcp<const SymEngine::Pow>(syms[s], exponent(e));
+        }
+        auto &cache = powers[s];
+        if (cache.size() <= e) {
+            cache.resize(e + 1);
+        }
+        if (cache[e].is_null()) {
+            cache[e] = SymEngine::make_rcp<const SymEngine::Pow>(syms[s], exponent(e));
+        }
+        return cache[e];
+    };
+
+    SymEngine::umap_basic_num dict;
+    dict.reserve(coefs.size());
+    for (auto &coef : coefs) {
+        const uint64_t nnz = get_varint(data, pos);
+        rcp_basic term;
+        if (nnz == 1) {
+            const uint64_t s = get_varint(data, pos), e = get_varint(data, pos);
+            if (s >= syms.size()) {throw std::runtime_error("Invalid symbol in polynomial");}
+            term = power(s, e);
+        } else {
+            SymEngine::map_basic_basic d;
+            for (uint64_t k = 0; k < nnz; k++) {
+                const uint64_t s = get_varint(data, pos), e = get_varint(data, pos);
+                if (s >= syms.size()) {throw std::runtime_error("Invalid symbol in polynomial");}
+                d[syms[s]] = exponent(e);
+            }
+            if (d.empty()) {
+                SymEngine::iaddnum(SymEngine::outArg(constant), coef);
+                continue;
+            }
+            term = SymEngine::make_rcp<const SymEngine::Mul>(SymEngine::one, std::move(d));
+        }
+        SymEngine::Add::dict_add_term(dict, coef, term);
+    }
+    return SymEngine::Add::from_dict(constant, std::move(dict));
+}
@@ -0,0 +1,338 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <symengine/basic.h>
+#include <symengine/add.h>
+#include <symengine/mul.h>
+#include <symengine/pow.h>
+#include <symengine/symbol.h>
+#include <symengine/integer.h>
+#include <symengine/rational.h>
+#include "utils/varint_codec.h"
+
+/**
+ * The names of the symbols, each one stored once and referred to by a varint id.
+ * Through `Basic::dumps()` every record carries the full name of every symbol it uses, and every load allocates a new
+ * string and a new Symbol per name. With a table shared by all the records of a file, a record only stores the ids,
+ * and `loads()` interns all the names into Symbols in one pass, which are then shared by all the loaded records.
+ */
+class symbol_table {
+private:
+    std::vector<std::string> m_vNames;
+    std::unordered_map<SymEngine::RCP<const SymEngine::Basic>, uint64_t, SymEngine::RCPBasicHash,
+                       SymEngine::RCPBasicKeyEq> m_mIds;
+    SymEngine::vec_basic m_vSymbols;
+
+public:
+    size_t size() const {
+        return m_vNames.size();
+    }
+
+    /**
+     * @return The id of `sym`, registering it if it is new.
+     */
+    uint64_t id_of(const SymEngine::RCP<const SymEngine::Basic> &sym) {
+        auto it = m_mIds.find(sym);
+        if (it != m_mIds.end()) {
+            return it->second;
+        }
+        const uint64_t id = m_vNames.size();
+        m_vNames.push_back(SymEngine::down_cast<const SymEngine::Symbol &>(*sym).get_name());
+        m_vSymbols.push_back(sym);
+        m_mIds.emplace(sym, id);
+        return id;
+    }
+
+    const SymEngine::RCP<const SymEngine::Basic> &symbol_at(uint64_t id) const {
+        if (id >= m_vSymbols.size()) {
+            throw std::runtime_error("Invalid symbol id " + std::to_string(id));
+        }
+        return m_vSymbols[id];
+    }
+
+    void dumps(std::string &out) const {
+        codec::put_varint(out, m_vNames.size());
+        for (const auto &name : m_vNames) {
+            codec::put_string(out, name);
+        }
+    }
+
+    std::string dumps() const {
+        std::string out;
+        dumps(out);
+        return out;
+    }
+
+    /**
+     * Reads a table written by `dumps()` and creates all its symbols.
+     */
+    static symbol_table loads(const std::string &in, size_t &pos) {
+        symbol_table table;
+        const uint64_t count = codec::get_varint(in, pos);
+        table.m_vNames.reserve(count);
+        table.m_vSymbols.reserve(count);
+        for (uint64_t i = 0; i < count; i++) {
+            table.m_vNames.push_back(codec::get_string(in, pos));
+            table.m_vSymbols.push_back(SymEngine::symbol(table.m_vNames.back()));
+        }
+        return table;
+    }
+
+    static symbol_table loads(const std::string &in) {
+        size_t pos = 0;
+        return loads(in, pos);
+    }
+};
+
+/**
+ * Serializes a vec_basic as a DAG: every node is written once, after its children, and is referred to by its index.
+ * The symbols are written as ids of a symbol_table, which is either embedded in the output (one table per archive) or
+ * kept by the caller and shared by several outputs (one table per file, see `dumps_symtab(exprs, table)`).
+ *
+ *  "SYT1" | embedded (u8) | [table] | node count | nodes | root count | roots
+ *
+ * The Symbol, Integer, Rational, Add, Mul and Pow nodes are encoded natively; any other node is embedded as a
+ * `Basic::dumps()` blob.
+ */
+namespace symtab_detail {
+    using rcp_basic = SymEngine::RCP<const SymEngine::Basic>;
+
+    enum tag : uint8_t {
+        TAG_SYMBOL = 1,
+        TAG_INTEGER,
+        TAG_RATIONAL,
+        TAG_ADD,
+        TAG_MUL,
+        TAG_POW,
+        TAG_BLOB
+    };
+
+    template<typename Fn>
+    void for_each_child(const SymEngine::Basic &x, Fn &&fn) {
+        if (SymEngine::is_a<SymEngine::Add>(x)) {
+            const auto &a = SymEngine::down_cast<const SymEngine::Add &>(x);
+            fn(a.get_coef());
+            for (const auto &[term, coef] : a.get_dict()) {
+                fn(term);
+                fn(coef);
+            }
+        } else if (SymEngine::is_a<SymEngine::Mul>(x)) {
+            const auto &m = SymEngine::down_cast<const SymEngine::Mul &>(x);
+            fn(m.get_coef());
+            for (const auto &[base, exp] : m.get_dict()) {
+                fn(base);
+                fn(exp);
+            }
+        } else if (SymEngine::is_a<SymEngine::Pow>(x)) {
+            const auto &p = SymEngine::down_cast<const SymEngine::Pow &>(x);
+            fn(p.get_base());
+            fn(p.get_exp());
+        }
+    }
+
+    /**
+     * Calls `visit(x)` once on every node of the DAG of `exprs`, after its children. `visited(x)` tells whether the node
+     * was visited already, which `visit(x)` has to make true. The traversal uses an explicit stack, so that deep exprs do
+     * not overflow the call stack.
+     */
+    template<typename Visited, typename Visit>
+    void for_each_post_order(const SymEngine::vec_basic &exprs, Visited &&visited, Visit &&visit) {
+        std::vector<std::pair<rcp_basic, bool>> stack;
+        for (const auto &e : exprs) {
+            stack.emplace_back(e, false);
+            while (!stack.empty()) {
+                auto [x, expanded] = stack.back();
+                stack.pop_back();
+                if (visited(x)) {
+                    continue;
+                }
+                if (expanded) {
+                    visit(x);
+                    continue;
+                }
+                stack.emplace_back(x, true);
+                for_each_child(*x, [&](const rcp_basic &c) {
+                    if (!visited(c)) {
+                        stack.emplace_back(c, false);
+                    }
+                });
+            }
+        }
+    }
+
+    inline void encode(const SymEngine::vec_basic &exprs, symbol_table &table, std::string &out) {
+        std::unordered_map<const SymEngine::Basic *, uint64_t> ids;
+        std::string nodes;
+        uint64_t count = 0;
+
+        auto write_node = [&](const rcp_basic &x) {
+            const SymEngine::Basic &b = *x;
+            if (SymEngine::is_a<SymEngine::Symbol>(b)) {
+                nodes.push_back(TAG_SYMBOL);
+                codec::put_varint(nodes, table.id_of(x));
+            } else if (SymEngine::is_a<SymEngine::Integer>(b)) {
+                nodes.push_back(TAG_INTEGER);
+                codec::put_integer(nodes, SymEngine::down_cast<const SymEngine::Integer &>(b));
+            } else if (SymEngine::is_a<SymEngine::Rational>(b)) {
+                const auto &r = SymEngine::down_cast<const SymEngine::Rational &>(b);
+                nodes.push_back(TAG_RATIONAL);
+                codec::put_integer(nodes, *r.get_num());
+                codec::put_integer(nodes, *r.get_den());
+            } else if (SymEngine::is_a<SymEngine::Add>(b) || SymEngine::is_a<SymEngine::Mul>(b) ||
+                       SymEngine::is_a<SymEngine::Pow>(b)) {
+                nodes.push_back(SymEngine::is_a<SymEngine::Add>(b) ? TAG_ADD :
+                                SymEngine::is_a<SymEngine::Mul>(b) ? TAG_MUL : TAG_POW);
+                if (SymEngine::is_a<SymEngine::Add>(b)) {
+                    codec::put_varint(nodes, SymEngine::down_cast<const SymEngine::Add &>(b).get_dict().size());
+                } else if (SymEngine::is_a<SymEngine::Mul>(b)) {
+                    codec::put_varint(nodes, SymEngine::down_cast<const SymEngine::Mul &>(b).get_dict().size());
+                }
+                for_each_child(b, [&](const rcp_basic &c) {
+                    codec::put_varint(nodes, ids.at(c.get()));
+                });
+            } else {
+                nodes.push_back(TAG_BLOB);
+                codec::put_string(nodes, b.dumps());
+            }
+            ids.emplace(&b, count++);
+        };
+
+        for_each_post_order(exprs, [&](const rcp_basic &x) {
+            return ids.count(x.get()) != 0;
+        }, write_node);
+
+        codec::put_varint(out, count);
+        out += nodes;
+        codec::put_varint(out, exprs.size());
+        for (const auto &e : exprs) {
+            codec::put_varint(out, ids.at(e.get()));
+        }
+    }
+
+    inline SymEngine::vec_basic decode(const std::string &in, size_t &pos, const symbol_table &table) {
+        std::vector<rcp_basic> nodes(codec::get_varint(in, pos));
+        auto node = [&](size_t limit) -> const rcp_basic & {
+            const uint64_t id = codec::get_varint(in, pos);
+            if (id >= limit) {
+                throw std::runtime_error("Invalid node id " + std::to_string(id));
+            }
+            return nodes[id];
+        };
+        auto number = [&](size_t limit) {
+            const auto &n = node(limit);
+            if (!SymEngine::is_a_Number(*n)) {
+                throw std::runtime_error("Expected a number");
+            }
+            return SymEngine::rcp_static_cast<const SymEngine::Number>(n);
+        };
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (pos >= in.size()) {
+                throw std::runtime_error("Truncated data");
+            }
+            switch (static_cast<uint8_t>(in[pos++])) {
+                case TAG_SYMBOL:
+                    nodes[i] = table.symbol_at(codec::get_varint(in, pos));
+                    break;
+                case TAG_INTEGER:
+                    nodes[i] = codec::get_integer(in, pos);
+                    break;
+                case TAG_RATIONAL: {
+                    auto num = codec::get_integer(in, pos);
+                    auto den = codec::get_integer(in, pos);
+                    nodes[i] = SymEngine::Rational::from_two_ints(*num, *den);
+                    break;
+                }
+                case TAG_ADD: {
+                    const uint64_t pairs = codec::get_varint(in, pos);
+                    auto coef = number(i);
+                    SymEngine::umap_basic_num dict;
+                    dict.reserve(pairs);
+                    for (uint64_t k = 0; k < pairs; k++) {
+                        const auto &term = node(i);
+                        dict[term] = number(i);
+                    }
+                    nodes[i] = SymEngine::Add::from_dict(coef, std::move(dict));
+                    break;
+                }
+                case TAG_MUL: {
+                    const uint64_t pairs = codec::get_varint(in, pos);
+                    auto coef = number(i);
+                    SymEngine::map_basic_basic dict;
+                    for (uint64_t k = 0; k < pairs; k++) {
+                        const auto &base = node(i);
+                        dict[base] = node(i);
+                    }
+                    nodes[i] = SymEngine::Mul::from_dict(coef, std::move(dict));
+                    break;
+                }
+                case TAG_POW: {
+                    const auto &base = node(i);
+                    nodes[i] = SymEngine::make_rcp<const SymEngine::Pow>(base, node(i));
+                    break;
+                }
+                case TAG_BLOB:
+                    nodes[i] = SymEngine::Basic::loads(codec::get_string(in, pos));
+                    break;
+                default:
+                    throw std::runtime_error("Invalid node tag");
+            }
+        }
+
+        SymEngine::vec_basic roots(codec::get_varint(in, pos));
+        for (auto &r : roots) {
+            r = node(nodes.size());
+        }
+        return roots;
+    }
+}
+
+/**
+ * One table per archive: the names of the symbols used by `exprs` are embedded in the output, once each.
+ */
+inline std::string dumps_symtab(const SymEngine::vec_basic &exprs) {
+    symbol_table table;
+    std::string body;
+    symtab_detail::encode(exprs, table, body);
+    std::string out = "SYT1";
+    out.push_back(1);
+    table.dumps(out);
+    return out + body;
+}
+
+/**
+ * One table per file: the symbols are registered into `table`, which the caller stores once for all the outputs that
+ * share it and passes back to `loads_symtab()`.
+ */
+inline std::string dumps_symtab(const SymEngine::vec_basic &exprs, symbol_table &table) {
+    std::string out = "SYT1";
+    out.push_back(0);
+    symtab_detail::encode(exprs, table, out);
+    return out;
+}
+
+/**
+ * @param table The shared table of the outputs of `dumps_symtab(exprs, table)`, unused for the ones with an embedded
+ * table.
+ */
+inline SymEngine::vec_basic loads_symtab(const std::string &data, const symbol_table &table = symbol_table()) {
+    if (data.size() < 5 || data.compare(0, 4, "SYT1") != 0) {
+        throw std::runtime_error("Not a symbol table archive");
+    }
+    size_t pos = 5;
+    if (data[4] != 0) {
+        const auto embedded = symbol_table::loads(data, pos);
+        return symtab_detail::decode(data, pos, embedded);
+    }
+    return symtab_detail::decode(data, pos, table);
+}
@@ -5,6 +5,53 @@
 #include "timers.h"
 #include <algorithm>
 #include <cstdlib>
+#include <unordered_map>
+
+std::atomic<uint64_t> timer_stats::s_lNextInstanceId{1};
+
+namespace {
+    /**
+     * A small dense id per thread, so the per-thread breakdown is readable.
+     */
+    size_t thread_ordinal() {
+        static std::atomic<size_t> s_lNextOrdinal{0};
+        thread_local size_t t_lOrdinal = s_lNextOrdinal++;
+        return t_lOrdinal;
+    }
+}
+
+latency_histogram& timer_stats::local_histogram() {
+    // Instance ids are never reused, so a stale entry of a destroyed instance can never be hit.
+    thread_local uint64_t t_lLastId = 0;
+    thread_local latency_histogram* t_pLastHist = nullptr;
+    if (t_lLastId == m_lInstanceId) {
+        return *t_pLastHist;
+    }
+
+    thread_local std::unordered_map<uint64_t, latency_histogram*> t_mShards;
+    auto it = t_mShards.find(m_lInstanceId);
+    latency_histogram* hist;
+    if (it != t_mShards.end()) {
+        hist = it->second;
+    } else {
+        std::lock_guard<std::mutex> lock(m_oMutexShards);
+        m_vShards.push_back(std::make_unique<thread_shard>(thread_ordinal()));
+        hist = &m_vShards.back()->pending;
+        t_mShards[m_lInstanceId] = hist;
+    }
+    t_lLastId = m_lInstanceId;
+    t_pLastHist = hist;
+    return *hist;
+}
+
+void timer_stats::flush_threads() {
+    std::lock_guard<std::mutex> lock(m_oMutexShards);
+    for (auto &shard : m_vShards) {
+        samples.merge(shard->pending);
+        shard->total.merge(shard->pending);
+        shard->pending.reset();
+    }
+}
 
 std::string timer_stats::legalize_filename(const std::string& name) const {
     std::string result = name;
@@ -39,13 +86,14 @@ std::string timer_stats::pairs_to_json() const {
     return result;
 }
 
-std::string timer_stats::data_to_json() const {
+std::string timer_stats::histogram_to_json() const {
+    // [[lower_ns, upper_ns, count], ...] for the non-empty buckets only.
     std::string result = "[";
-    for (auto &s : samples) {
-        result += std::to_string(s) + ", ";
-    }
+    samples.for_each_bucket([&](uint64_t lo, uint64_t hi, uint64_t cnt) {
+        result += "[" + std::to_string(lo) + ", " + std::to_string(hi) + ", " + std::to_string(cnt) + "], ";
+    });
     // remove the last comma and space if its not empty
-    if (pairs.size() > 0) {
+    if (samples.count() > 0) {
         result.pop_back();
         result.pop_back();
     }
@@ -53,53 +101,47 @@ std::string timer_stats::data_to_json() const {
     return result;
 }
 
-float timer_stats::ave() const {
-    // Calculate the average with vector
-    float sum = 0;
-    for (auto t : samples) {
-        sum += t;
+std::string timer_stats::threads_to_json() const {
+    std::string result = "[";
+    for (auto &shard : m_vShards) {
+        const auto &h = shard->total;
+        result += "{\"thread\": " + std::to_string(shard->thread_ordinal) +
+            ", \"samples\": " + std::to_string(h.count()) +
+            ", \"p50\": " + std::to_string(h.percentile(50) / 1e6) +
+            ", \"p99\": " + std::to_string(h.percentile(99) / 1e6) +
+            ", \"max\": " + std::to_string(h.max() / 1e6) + "}, ";
+    }
+    if (!m_vShards.empty()) {
+        result.pop_back();
+        result.pop_back();
     }
-    return sum / samples.size();
+    result += "]";
+    return result;
+}
+
+float timer_stats::ave() const {
+    return static_cast<float>(samples.mean() / 1e6);
 }
 
 float timer_stats::max() const {
-    float max = samples[0];
-    for (size_t i = 1; i < samples.size(); i++) {
-        if (samples[i] > max) {
-            max = samples[i];
-        }
-    }
-    return max;
+    return static_cast<float>(samples.max() / 1e6);
 }
 
 float timer_stats::min() const {
-    float min = samples[0];
-    for (size_t i = 1; i < samples.size(); i++) {
-        if (samples[i] < min) {
-            min = samples[i];
-        }
-    }
-    return min;
+    return static_cast<float>(samples.min() / 1e6);
 }
 
 float timer_stats::median() const {
-    std::vector<float> v = samples;
-    std::sort(v.begin(), v.end());
-    size_t n = v.size();
-    if (n % 2 == 0) {
-        return (v[n / 2 - 1] + v[n / 2]) / 2;
-    } else {
-        return v[n / 2];
-    }
+    return percentile(50);
+}
+
+float timer_stats::percentile(double p) const {
+    return static_cast<float>(samples.percentile(p) / 1e6);
 }
 
 float timer_stats::variance() const {
-    float avg = ave();
-    float sum = 0;
-    for (auto t : samples) {
-        sum += (t - avg) * (t - avg);
-    }
-    return sum / samples.size();
+    // ns^2 to ms^2
+    return static_cast<float>(samples.variance() / 1e12);
 }
 
 void timer_stats::print() const {
@@ -109,8 +151,18 @@ void timer_stats::print() const {
     std::cout << "> Average: \t" << ave() << std::endl;
     std::cout << "> Samples: \t" << count() << std::endl;
     std::cout << "> Variance:\t" << variance() << std::endl;
+    std::cout << "> P90:     \t" << percentile(90) << std::endl;
+    std::cout << "> P99:     \t" << percentile(99) << std::endl;
+    std::cout << "> P99.9:   \t" << percentile(99.9) << std::endl;
     std::cout << "> Max:     \t" << max() << std::endl;
     std::cout << "> Min:     \t" << min() << std::endl;
+    if (m_vShards.size() > 1) {
+        for (auto &shard : m_vShards) {
+            const auto &h = shard->total;
+            std::cout << "> Thread " << shard->thread_ordinal << ":\t" << h.count() << " samples, p50 " <<
+                h.percentile(50) / 1e6 << ", p99 " << h.percentile(99) / 1e6 << ", max " << h.max() / 1e6 << std::endl;
+        }
+    }
     std::cout << "============================================" << std::endl;
 }
 
@@ -122,12 +174,16 @@ void timer_stats::save() const {
     file << "\"name\": \"" << name << "\",\n";
     file << "\"pairs\": " << pairs_to_json() << ",\n";
     file << "\"samples\": " << count() << ",\n";
-    file << "\"data\": " << data_to_json() << ", \n";
+    file << "\"histogram_ns\": " << histogram_to_json() << ", \n";
     file << "\"average\": " << ave() << ",\n";
     file << "\"median\": " << median() << ",\n";
+    file << "\"p90\": " << percentile(90) << ",\n";
+    file << "\"p99\": " << percentile(99) << ",\n";
+    file << "\"p99.9\": " << percentile(99.9) << ",\n";
     file << "\"variance\": " << variance() << ",\n";
     file << "\"max\": " << max() << ",\n";
-    file << "\"min\": " << min() << "\n";
+    file << "\"min\": " << min() << ",\n";
+    file << "\"threads\": " << threads_to_json() << "\n";
     file << "}\n";
     file.close();
 }
@@ -136,6 +192,6 @@ timer_scope::~timer_scope() {
     if(m_bIsRoot) {
         report_from_last(name);
     } else {
-        m_pStats->add_sample(from_last());
+        m_pStats->add_sample_ns(from_last_ns());
     }
 }
@@ -11,20 +11,60 @@
 #include <memory>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <ctime>
 
-using std::chrono::high_resolution_clock;
+#include "latency_histogram.h"
+
+using std::chrono::steady_clock;
 using std::chrono::duration_cast;
 using std::chrono::duration;
 using std::chrono::milliseconds;
 
+/**
+ * Reads CLOCK_MONOTONIC through the vDSO, which avoids a syscall and is not affected by wall-clock adjustments.
+ * @return The current monotonic time in nanoseconds.
+ */
+static inline uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
 class timer_scope; // Forward declaration
+
+/**
+ * Latency statistics that can be fed concurrently from several threads.
+ * Every thread records into its own histogram shard, so the hot path (`add_sample*()` and `timer_scope`) takes no lock;
+ * the registry mutex is only touched the first time a thread records into a given instance.
+ * The shards are folded into the aggregate by `flush_threads()`, which must be called once the recording threads are
+ * done (e.g. after joining the workers of a parallel phase). The destructor flushes before printing and saving.
+ */
 class timer_stats {
     friend class timer_scope;
 
 private:
+    struct thread_shard {
+        const size_t thread_ordinal;
+        latency_histogram pending; // only written by the owning thread
+        latency_histogram total;   // per-thread breakdown, updated on flush
+
+        explicit thread_shard(size_t ordinal) : thread_ordinal(ordinal) {
+        }
+    };
+
+    static std::atomic<uint64_t> s_lNextInstanceId;
+
     const std::string name;
-    std::vector<float> samples;
+    const uint64_t m_lInstanceId;
+    latency_histogram samples;
     const std::map<std::string, int> pairs;
+    std::mutex m_oMutexShards;
+    std::vector<std::unique_ptr<thread_shard>> m_vShards;
 
     std::string legalize_filename(const std::string& name) const;
 
@@ -32,21 +72,43 @@ private:
 
     std::string pairs_to_json() const;
 
-    std::string data_to_json() const;
+    std::string histogram_to_json() const;
+
+    std::string threads_to_json() const;
+
+    latency_histogram& local_histogram();
 
 public:
-    timer_stats(const std::string& name) : name(name) {
+    timer_stats(const std::string& name) : name(name), m_lInstanceId(s_lNextInstanceId++) {
     }
 
-    timer_stats(const std::string& name, const std::map<std::string, int>& pairs) : name(name), pairs(pairs) {
+    timer_stats(const std::string& name, const std::map<std::string, int>& pairs) :
+        name(name), m_lInstanceId(s_lNextInstanceId++), pairs(pairs) {
     }
 
+    /**
+     * @param time The sample in milliseconds.
+     */
     void add_sample(float time) {
-        samples.push_back(time);
+        local_histogram().record(static_cast<uint64_t>(std::llround(static_cast<double>(time) * 1e6)));
+    }
+
+    void add_sample_ns(uint64_t ns) {
+        local_histogram().record(ns);
+    }
+
+    /**
+     * Folds the per-thread shards into the aggregate. Not safe to call while other threads are still recording.
+     */
+    void flush_threads();
+
+    void merge(timer_stats& other) {
+        other.flush_threads();
+        samples.merge(other.samples);
     }
 
     size_t count() const {
-        return samples.size();
+        return samples.count();
     }
 
     float ave() const;
@@ -57,6 +119,12 @@ public:
 
     float median() const;
 
+    /**
+     * @param p The percentile in [0, 100].
+     * @return The p-th percentile in milliseconds, with the relative error of the underlying histogram.
+     */
+    float percentile(double p) const;
+
     float variance() const;
 
     void print() const;
@@ -64,6 +132,7 @@ public:
     void save() const;
 
     ~timer_stats() {
+        flush_threads();
         print();
         save();
     }
@@ -71,32 +140,44 @@ public:
 
 class timer_scope {
 private:
-    std::chrono::system_clock::time_point m_oTimerLast;
+    steady_clock::time_point m_oTimerLast;
+    uint64_t m_lLastNs;
     const std::string name;
     const bool m_bIsRoot;
     timer_stats* m_pStats; // to keep things simple, we are not using smart pointers.
 
 public:
     timer_scope(const std::string& name) : name(name), m_bIsRoot(true) {
-        m_oTimerLast = high_resolution_clock::now();
+        m_oTimerLast = steady_clock::now();
         m_pStats = nullptr;
+        m_lLastNs = monotonic_ns();
     }
 
     timer_scope(timer_stats& parent) : name(""), m_bIsRoot(false) {
-        m_oTimerLast = high_resolution_clock::now();
+        m_oTimerLast = steady_clock::now();
         m_pStats = &parent;
+        m_lLastNs = monotonic_ns();
     }
 
     ~timer_scope();
 
     template <class StdTimeResolution = std::milli>
     float from_last() {
-        auto now = high_resolution_clock::now();
+        auto now = steady_clock::now();
         duration<float, StdTimeResolution> ms = now - m_oTimerLast;
         m_oTimerLast = now;
+        m_lLastNs = monotonic_ns();
         return ms.count();
     }
 
+    uint64_t from_last_ns() {
+        auto now = monotonic_ns();
+        auto ns = now - m_lLastNs;
+        m_lLastNs = now;
+        m_oTimerLast = steady_clock::now();
+        return ns;
+    }
+
     template <class StdTimeResolution = std::milli>
     float report_from_last(const std::string& msg = "") {
         auto t = from_last<StdTimeResolution>();
@@ -106,9 +187,9 @@ public:
 
     template <class StdTimeResolution = std::milli>
     static inline float for_lambda(const std::function<void()>& operation) {
-        auto t1 = high_resolution_clock::now();
+        auto t1 = steady_clock::now();
         operation();
-        auto t2 = high_resolution_clock::now();
+        auto t2 = steady_clock::now();
         duration<float, StdTimeResolution> ms = t2 - t1;
         return ms.count();
     }
@@ -0,0 +1,82 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <symengine/basic.h>
+#include <symengine/integer.h>
+
+/**
+ * The primitives shared by the compact storage formats of utils/ (poly_codec.h, symtab_codec.h):
+ *  - LEB128 varints.
+ *  - Integers: a tag byte, then a zigzag varint, or the decimal string when the value does not fit in a long.
+ *  - Strings: a varint length, then the bytes.
+ * The readers advance `pos` and throw on truncated input.
+ */
+namespace codec {
+    inline void put_varint(std::string &out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    inline uint64_t get_varint(const std::string &in, size_t &pos) {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= in.size()) {
+                throw std::runtime_error("Truncated data");
+            }
+            const auto byte = static_cast<unsigned char>(in[pos++]);
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return v;
+            }
+        }
+        throw std::runtime_error("Invalid varint");
+    }
+
+    inline void put_string(std::string &out, const std::string &s) {
+        put_varint(out, s.size());
+        out += s;
+    }
+
+    inline std::string get_string(const std::string &in, size_t &pos) {
+        const uint64_t len = get_varint(in, pos);
+        if (len > in.size() - pos) {
+            throw std::runtime_error("Truncated data");
+        }
+        auto s = in.substr(pos, len);
+        pos += len;
+        return s;
+    }
+
+    inline void put_integer(std::string &out, const SymEngine::Integer &x) {
+        const auto &i = x.as_integer_class();
+        if (SymEngine::mp_fits_slong_p(i)) {
+            const long v = SymEngine::mp_get_si(i);
+            out.push_back(0);
+            put_varint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        } else {
+            out.push_back(1);
+            put_string(out, x.__str__());
+        }
+    }
+
+    inline SymEngine::RCP<const SymEngine::Integer> get_integer(const std::string &in, size_t &pos) {
+        if (pos >= in.size()) {
+            throw std::runtime_error("Truncated data");
+        }
+        if (in[pos++] == 0) {
+            const uint64_t z = get_varint(in, pos);
+            return SymEngine::integer(static_cast<long>((z >> 1) ^ (~(z & 1) + 1)));
+        }
+        return SymEngine::integer(SymEngine::integer_class(get_string(in, pos)));
+    }
+}
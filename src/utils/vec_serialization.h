@@ -0,0 +1,75 @@
+//
+// Created by saleh on 10/19/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <symengine/symengine_config.h>
+#include <symengine/basic.h>
+#include <symengine/serialize-cereal.h>
+
+/**
+ * Serializes a whole vec_basic through a single archive, so the nodes shared between the exprs (the symbols, or
+ * any common sub-expression) are written once and are shared again after loading, unlike per-expr `dumps()`.
+ * The layout mirrors `Basic::dumps()`: the SymEngine version, then the element count and the elements.
+ */
+inline std::string dumps_vec(const SymEngine::vec_basic &exprs) {
+    std::ostringstream oss;
+    unsigned short major = SYMENGINE_MAJOR_VERSION;
+    unsigned short minor = SYMENGINE_MINOR_VERSION;
+    SymEngine::RCPBasicAwareOutputArchive<cereal::PortableBinaryOutputArchive> ar{oss};
+    ar(major, minor, static_cast<uint64_t>(exprs.size()));
+    for (const auto &e : exprs) {
+        ar(e);
+    }
+    return oss.str();
+}
+
+inline SymEngine::vec_basic loads_vec(const std::string &serialized) {
+    std::istringstream iss(serialized);
+    SymEngine::RCPBasicAwareInputArchive<cereal::PortableBinaryInputArchive> ar{iss};
+    unsigned short major, minor;
+    uint64_t count;
+    ar(major, minor, count);
+    if (major != SYMENGINE_MAJOR_VERSION || minor != SYMENGINE_MINOR_VERSION) {
+        throw std::runtime_error("Incompatible SymEngine version of the serialized vec_basic");
+    }
+    SymEngine::vec_basic exprs(count);
+    for (auto &e : exprs) {
+        ar(e);
+    }
+    return exprs;
+}
+
+/**
+ * Serializes an expr straight into `os`, byte for byte what `expr->dumps()` returns (so `Basic::loads()` reads it
+ * back), without building the blob in an intermediate std::string first.
+ */
+inline void dump_to(std::ostream &os, const SymEngine::RCP<const SymEngine::Basic> &expr) {
+    unsigned short major = SYMENGINE_MAJOR_VERSION;
+    unsigned short minor = SYMENGINE_MINOR_VERSION;
+    SymEngine::RCPBasicAwareOutputArchive<cereal::PortableBinaryOutputArchive> ar{os};
+    ar(major, minor, expr);
+}
+
+inline void write_blob(const std::string &path, const std::string &data) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {throw std::runtime_error("Cannot open file " + path);}
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+inline std::string read_blob(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {throw std::runtime_error("Cannot open file " + path);}
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(&data[0], static_cast<std::streamsize>(data.size()));
+    return data;
+}
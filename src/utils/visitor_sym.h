@@ -15,6 +15,7 @@
 #include <symengine/logic.h>
 #include <symengine/printers/strprinter.h>
 #include <symengine/visitor.h>
+#include <unordered_map>
 
 
 class visitor_sym: public SymEngine::BaseVisitor<visitor_sym> {
@@ -94,3 +95,26 @@ protected:
     SymEngine::vec_basic vec_sym;
     size_t count_duplicates;
 };
+
+
+/**
+ * Counts the distinct nodes reachable from `exprs`, as seen through `get_args()`.
+ * Shared sub-expressions are counted once, so this is the size of the DAG rather than of the tree.
+ */
+inline size_t count_unique_nodes(const SymEngine::vec_basic &exprs) {
+    // Keep the RCPs alive: get_args() may hand out temporaries (e.g. coef*term of an Add) whose addresses
+    // could otherwise be reused by later allocations.
+    std::unordered_map<const SymEngine::Basic*, SymEngine::RCP<const SymEngine::Basic>> seen;
+    SymEngine::vec_basic stack(exprs.begin(), exprs.end());
+    while (!stack.empty()) {
+        auto p = stack.back();
+        stack.pop_back();
+        if (!seen.emplace(p.get(), p).second) {
+            continue;
+        }
+        for (auto &arg : p->get_args()) {
+            stack.push_back(arg);
+        }
+    }
+    return seen.size();
+}